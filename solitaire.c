@@ -1,1487 +1,8391 @@
-//-----------------------------------------------------------------------------
-//
-// A simplified Solitaire game. The game is controlled/played via the command
-// line console, and the game is set up by calling the main function alongside
-// a file which contains the order of the cards, as described on Palme.
-// The game ends once all cards have been moved to deposit decks, or the user
-// enters "exit\n", or EOF. The rules are the same as in regular solitaire.
-// There are only 2 types of cards, reds and blacks, each has 13 instances.
-// Each card is unique.
-//
-//-----------------------------------------------------------------------------
-//
-
-#include <stdio.h>
-#include <string.h>
-#include <stdlib.h>
-#include <ctype.h>
-
-
-struct _Card_
-{
-  char color_;
-  int value_;
-  struct _Card_ *prev_;
-  struct _Card_ *next_;
-};
-typedef struct _Card_ Card;
-
-//Forward declarations
-int checkCardValue(char *tok);
-int checkForEmptyLine(char *line);
-void setFirstPointers(Card** deck, Card* card_instance);
-char checkCardColor(char* tok);
-int checkForSameCard(Card *cards, int i);
-int entireInputFromFile(FILE *config_file, Card *card_instance);
-int checkDeckNumber(char* tok);
-int checkUserInput();
-int checkCardsBelow(Card card_instance);
-Card* travelToTheBottom(Card* card_instance);
-int checkForValidMove(Card** deck,Card *wanted_card,int current_deck,
-                      int move_var);
-int checkMoveForDeposit(Card** deck, Card* wanted_card,int current_deck,
-                        int move_var);
-int travelToTheTop(Card** deck, Card *card_instance);
-Card* findCardFromMoveVar(int move_var, Card* card_instance);
-int printFunctionForAbhabeStapel(Card *ptr);
-int printCardFromValue(Card* ptr);
-int mainPrintFunction(Card** deck);
-Card* getNextCard(Card* CurrentCard);
-int printLines(Card** column);
-int mainGameFunction(Card** deck, Card* card_instance);
-
-
-
-
-
-
-
-
-//-----------------------------------------------------------------------------
-///
-/// The main program.
-/// Main function opens a file a reads the input. Errors are executed
-/// in case of invalid file or invalid file name. Memory is allocated
-/// for 26 cards. There are 7 pointers for decks and 26 pointers for
-/// cards. When the board is printed we enter the while loop in order
-/// to start printing our cards on the board.
-///
-/// @param argc used to check is program called with exactly one extra
-/// argument
-/// @param argv used to access a input file
-///
-/// @return 0 if program was ran successfully
-/// @return 1 if no file name was given to the run of the program
-/// @return 2 if out of memory
-/// @return 3 if invalid file
-//
-int main(int argc, char *argv[])
-{
-  if (argc != 2)
-  {
-    printf("[ERR] Usage: %s [file-name]\n", argv[0]);
-    return 1;
-  }
-  FILE *config_file;
-  config_file = fopen(argv[1], "r");
-  Card *card_instance;
-  card_instance = (Card*)malloc(26 * sizeof(Card));
-  if (card_instance == NULL)
-  {
-	  free(card_instance);
-	  printf("[ERR] Out of memory\n");
-	  return 2;
-  }  
-  int err_var = entireInputFromFile(config_file, card_instance);
-  if (err_var == 3)
-  {
-    printf("[ERR] Invalid file!\n");
-    return 3;
-  }
-  else if (err_var == 2)
-  {
-	  free(card_instance);
-	  return 2;
-  }   
-  Card** deck;
-  deck = (Card**)malloc(7 * sizeof(Card*));
-  if (deck == NULL)
-  {
-	  free(card_instance);
-	  free(deck);
-	  printf("[ERR] Out of memory\n");
-	  return 2;
-  }
-  setFirstPointers(deck, card_instance);
-  
-  ///////////////////////////////////////
-  err_var = mainPrintFunction(deck);
-  if (err_var == 2)
-  {
-	  free(deck);
-	  free(card_instance);
-	  return 2;
-  }  
-  while (1)
-  {
-    err_var = mainGameFunction(deck, card_instance);
-    if (err_var == 2)
-    {
-      free(card_instance);
-      free(deck);
-      return 2;
-    }
-    else if (err_var == 0)
-      break;
-    else
-      continue;
-  }
-  free(deck);
-  free(card_instance);
-  return 0;
-}
-
-
-
-
-
-
-
-
-
-
-//-----------------------------------------------------------------------------
-///
-/// Check if game is over. Checks if user input is a valid command.
-/// If user input is a valid command it changes necessary pointers and
-/// prints a new board. 
-///
-/// @param deck array of pointers to the first card in every deck
-/// @param card_instance array of cards in the double-linked list
-///
-/// @return 0 program is over
-/// @return 1 if move command was successful
-/// @return 2 if out of memory
-//
-int mainGameFunction(Card** deck, Card* card_instance)
-{
-  if ((deck[0] == NULL) && (deck[1] == NULL) && (deck[2] == NULL) &&
-      (deck[3] == NULL) && (deck[4] == NULL))
-  {
-    return 0;
-  }
-  Card *wanted_card;
-  int current_deck;
-  int wanted_deck;
-  int move_var = checkUserInput();
-  if (move_var == 2)
-  {
-    return 2;
-  }
-  else if (move_var == -2)
-  {
-    printf("[INFO] Invalid command!\n");
-    return 1;
-  }
-  else if (move_var == -1)
-  {
-    printf("possible command:\n");
-    printf(" - move <color> <value> to <stacknumber>\n");
-    printf(" - help\n");
-    printf(" - exit\n");
-    return 1;
-  }
-  else if (move_var == 0)
-  {
-    return  0;
-  }
-  else
-  {
-    wanted_card = findCardFromMoveVar(move_var, card_instance);
-    current_deck = travelToTheTop(deck, wanted_card);
-    wanted_deck = move_var / 100;
-    if(wanted_deck == current_deck)
-    {
-      return -2;
-    }
-    if (((current_deck == 0) && (wanted_card->next_ != NULL)) ||
-        (current_deck == 5) || (current_deck == 6))
-    {
-      printf("[INFO] Invalid move command!\n");
-      move_var = -2;
-    }
-    else if (wanted_deck == 0)
-    {
-      printf("[INFO] Invalid move command!\n");
-      move_var = -2;
-    }
-    else if ((wanted_deck == 5) || (wanted_deck == 6))
-    {
-      move_var = checkMoveForDeposit(deck, wanted_card, current_deck,
-                                     wanted_deck);
-    }
-    else
-    {
-      move_var = checkForValidMove(deck, wanted_card, current_deck,
-                                   wanted_deck);
-    }
-    if ((move_var != -2) && (move_var != -1))
-    {
-      return mainPrintFunction(deck);
-    }
-  }
-  return 1;
-}
-
-//-----------------------------------------------------------------------------
-///
-/// Prints a table with first two rows same always, but under these two rows
-/// cards are changing and printing every time a successful command was ran.
-/// For loop is going through all decks and printing cards in one row.
-///
-/// @param deck array of pointers to the first card in every deck
-///
-/// @return 1 if printing was successful
-/// @return 2 if out of memory
-//
-int mainPrintFunction(Card** deck)
-{
-  int i;
-  int oom;
-  Card** column;
-  column = (Card**)malloc(7*sizeof(Card*));
-  if (column == NULL)
-  {
-	  free(column);
-	  printf("[ERR] Out of memory\n");
-	  return 2;
-  }  
-  for (i = 0; i < 7; i++)
-  {
-    column[i] = deck[i];
-  }
-  printf("0   | 1   | 2   | 3   | 4   | DEP | DEP\n");
-  printf("---------------------------------------\n");
-  oom = printLines(column);
-  if (oom == 2)
-  {
-	  free(column);
-    return 2;	
-  }
-  free(column);
-  return 1;
-}
-
-
-//-----------------------------------------------------------------------------
-///
-/// Prints the cards in one row separated by horizontal lines.
-/// These are printed in a way so that there are same number of slots
-/// of double-linked list from head pointers.
-///
-/// @param column array of pointers of cards in a same row
-///
-/// @return 0 if printing was successful
-/// @return 2 if out of memory
-//
-int printLines(Card** column)
-{
-  int i;
-  int j;
-  int oom;
-  for (i = 0; i < 16; i++)
-  {
-    oom = printFunctionForAbhabeStapel(column[0]);
-    if (oom == 2)
-    {
-      return 2;
-    }
-	  for (j = 1; j < 7; j++)
-	  {
-	    printf(" | ");
-	    oom = printCardFromValue(column[j]);
-	    if (oom == 2)
-      {
-        return 2;
-      }
-	  }
-	  printf("\n");
-	  for (j = 0; j < 7; j++)
-	  {
-	    column[j] = getNextCard(column[j]);
-	  }
-  }
-  return 0;
-}
-
-
-
-
-
-
-
-//-----------------------------------------------------------------------------
-///
-/// Simply gets the next card in a double-linked list
-///
-/// @param current_card used to point to a card
-///
-/// @return current_card->next_ pointer to the next card
-/// @return NULL if card is at the bottom of the double-linked list
-///
-Card* getNextCard(Card* current_card)
-{
-  if (current_card == NULL)
-  {
-    return NULL;
-  }
-  else
-  {
-    return current_card->next_;
-  }
-}
-
-
-
-
-
-
-//-----------------------------------------------------------------------------
-///
-/// Prints "X  " if card is not at the bottom of DLL
-/// Prints card if it is at the bottom
-/// Prints "   " if there is a slot under the bottom card of DLL
-///
-/// @param ptr used to point at a card
-///
-/// @return 0 if printing was successful
-/// @return 2 if out of memory
-//
-int printFunctionForAbhabeStapel(Card *ptr)
-{
-  int oom;
-  char* output;
-  output = (char*)malloc(4*sizeof(char));
-  if (output == NULL)
-  {
-  	free(output);
-	  printf("[ERR] Out of memory\n");
-	  return 2;
-  }  
-  if (ptr == NULL)
-  {
-    output[0] = ' ';
-    output[1] = ' ';
-    output[2] = ' ';
-    output[3] = '\0';
-    printf("%s", output);
-  }
-  else if (ptr->next_ != NULL)
-  {
-    output[0] = 'X';
-    output[1] = ' ';
-    output[2] = ' ';
-    output[3] = '\0';
-    printf("%s", output);
-  }
-  else
-  {
-    oom = printCardFromValue(ptr);
-  }
-  if (oom == 2)
-	  return 2;
-  free(output);
-  return 0;
-}
-
-
-
-
-
-
-//-----------------------------------------------------------------------------
-///
-/// Prints card if slot is populated by a card. Prints "   " if slot is
-/// empty.
-///
-/// @param ptr used to point at a card
-///
-/// @return 0 if printing was successful
-/// @return 2 if out of memory
-//
-int printCardFromValue(Card* ptr)
-{
-  char* output;
-  output = (char*)malloc(4*sizeof(char));
-  if (output == NULL)
-  {
-	  free(output);
-	  printf("[ERR] Out of memory\n");
-	  return 2;
-  }  
-  if (ptr == NULL)
-  {
-    output[0] = ' ';
-    output[1] = ' ';
-    output[2] = ' ';
-    output[3] = '\0';
-  }
-  else
-  {
-    output[0] = ptr->color_;
-    output[2] = ' ';
-    switch (ptr->value_)
-    {
-      case 1:
-        output[1] = 'A';
-        break;
-      case 2:
-        output[1] = '2';
-        break;
-      case 3:
-        output[1] = '3';
-        break;
-      case 4:
-        output[1] = '4';
-        break;
-      case 5:
-        output[1] = '5';
-        break;
-      case 6:
-        output[1] = '6';
-        break;
-      case 7:
-        output[1] = '7';
-        break;
-      case 8:
-        output[1] = '8';
-        break;
-      case 9:
-        output[1] = '9';
-        break;
-      case 10:
-        output[1] = '1';
-        output[2] = '0';
-        break;
-      case 11:
-        output[1] = 'J';
-        break;
-      case 12:
-        output[1] = 'Q';
-        break;
-      case 13:
-        output[1] = 'K';
-        break;
-    }
-    output[3] = '\0';
-  }
-  printf("%s", output);
-  free(output);
-  return 0;
-}
-
-
-
-
-
-
-
-
-
-//-----------------------------------------------------------------------------
-///
-/// Returns the number of the deck that the wanted card is in.
-///
-/// @param deck array of pointers to the first card in every deck
-/// @param wanted_card pointer to the wanted card
-///
-/// @return number of the deck the card is in
-//
-int travelToTheTop(Card** deck, Card *wanted_card)
-{
-  if (wanted_card->prev_ == NULL)
-  {
-    if (deck[0] == wanted_card)
-    {
-      return 0;
-    }
-    else if (deck[6] == wanted_card)
-    {
-      return 6;
-    }
-    else if (deck[5] == wanted_card)
-    {
-      return 5;
-    }
-    else if (deck[4] == wanted_card)
-    {
-      return 4;
-    }
-    else if (deck[3] == wanted_card)
-    {
-      return 3;
-    }
-    else if (deck[2] == wanted_card)
-    {
-      return 2;
-    }
-    else
-    {
-      return 1;
-    }
-  }
-  else
-  {
-    return travelToTheTop(deck, wanted_card->prev_);
-  }
-}
-
-
-
-
-
-
-//-----------------------------------------------------------------------------
-///
-/// Checks if inputted command is valid for the current game state.
-///
-/// @param deck array of pointers to the first card in every deck
-/// @param wanted_card pointer to the wanted card
-/// @param current_deck the deck that the card is in
-/// @param desired_deck the deck that we want to move the card to
-///
-/// @return 0 if move is permitted
-/// @return -2 if the move is invalid
-//
-int checkForValidMove(Card** deck,Card* wanted_card,
-                        int current_deck, int desired_deck)
-{
-  Card *ptr_to_btm;
-  ptr_to_btm = travelToTheBottom(deck[desired_deck]);
-  if (checkCardsBelow(*wanted_card) == -1)
-  {
-    printf("[INFO] Invalid move command!\n");
-    return -2;
-  }
-  if (ptr_to_btm == NULL)
-  {
-    if (wanted_card->value_ == 13)
-    {
-      deck[desired_deck] = wanted_card;
-      if (wanted_card->prev_ == NULL)
-      {
-        deck[current_deck] = NULL;
-      }
-      else
-      {
-        wanted_card->prev_->next_ = NULL;
-      }
-      wanted_card->prev_ = NULL;
-    }
-    else
-    {
-      printf("[INFO] Invalid move command!\n");
-      return -2;
-    }
-  }
-  else if (ptr_to_btm->color_ != wanted_card->color_)
-  {
-    if (ptr_to_btm->value_ == wanted_card->value_ + 1)
-    {
-      if (wanted_card->prev_ == NULL)
-      {
-        deck[current_deck] = NULL;
-      }
-      else
-      {
-        wanted_card->prev_->next_ = NULL;
-      }
-      wanted_card->prev_ = ptr_to_btm;
-      ptr_to_btm->next_ = wanted_card;
-    }
-    else
-    {
-      printf("[INFO] Invalid move command!\n");
-      return -2;
-    }
-  }
-  else
-  {
-    printf("[INFO] Invalid move command!\n");
-    return -2;
-  }
-  return 0;
-}
-
-
-
-
-//-----------------------------------------------------------------------------
-///
-/// Checks move command for deposit decks because of the special rules
-/// applied to these two decks.
-///
-/// @param deck array of pointers to the first card in every deck
-/// @param wanted_card pointer to the wanted card
-/// @param current_deck the deck that the card is in
-/// @param desired_deck the deck that we want to move the card to
-///
-/// @return 0 if move is permitted
-/// @return -2 if the move is invalid
-//
-int checkMoveForDeposit(Card** deck, Card* wanted_card, int current_deck,
-                         int desired_deck)
-{
-  Card* ptr_to_btm;
-  ptr_to_btm = travelToTheBottom(deck[desired_deck]);
-  if (wanted_card->next_ != NULL)
-  {
-    printf("[INFO] Invalid move command!\n");
-    return -2;
-  }
-  else if (ptr_to_btm == NULL)
-  {
-    if (wanted_card->value_ == 1)
-    {
-      if (wanted_card->prev_ == NULL)
-      {
-        deck[current_deck] = NULL;
-      }
-      else
-      {
-        wanted_card->prev_->next_ = NULL;
-      }
-      wanted_card->prev_ = ptr_to_btm;
-      deck[desired_deck] = wanted_card;
-    }
-    else
-    {
-      printf("[INFO] Invalid move command!\n");
-      return -2;
-    }
-  }
-  else
-  {
-    if (wanted_card->color_ == ptr_to_btm->color_)
-    {
-      if (wanted_card->value_ == ptr_to_btm->value_ + 1)
-      {
-        ptr_to_btm->next_ = wanted_card;
-        if (wanted_card->prev_ == NULL)
-        {
-          deck[current_deck] = NULL;
-        }
-        else
-        {
-          wanted_card->prev_->next_ = NULL;
-        }
-        wanted_card->prev_ = ptr_to_btm;
-      }
-      else
-      {
-        printf("[INFO] Invalid move command!\n");
-        return -2;
-      }
-    }
-    else
-    {
-      printf("[INFO] Invalid move command!\n");
-      return -2;
-    }
-  }
-  return 0;
-}
-
-
-
-
-
-
-
-
-
-//-----------------------------------------------------------------------------
-///
-/// Return the address of the card described by the user input. Three digit
-/// passed to the function, the last two digits are the description of the
-/// card, if bigger than 13, then card is black and value is for 13 less than
-/// the last two digits, otherwise two digits are the value and the color is
-/// red.
-///
-/// @param move_var the number containing description of the wanted card
-/// @param card_instance array of cards
-///
-/// @return &card_instance[i]
-//
-Card* findCardFromMoveVar(int move_var, Card* card_instance)
-{
-  int card_value;
-  char card_color;
-  card_value = move_var % 100;
-  if (card_value > 13)
-  {
-    card_color = 'B';
-    card_value -= 13;
-  }
-  else
-  {
-    card_color = 'R';
-  }
-  int i;
-  for (i = 0; i < 26; i++)
-  {
-    if (card_instance[i].value_ == card_value)
-    {
-      if (card_instance[i].color_ == card_color)
-      {
-        break;
-      }
-    }
-  }
-  return &card_instance[i];
-}
-
-
-
-
-//-----------------------------------------------------------------------------
-///
-/// Function that goes to the bottom of the linked list and than it returns
-/// address of the card at the bottom.
-///
-/// @param card_instance pointer to card for which deck we want to check for
-///
-/// @return card_instance if it is at the bottom
-/// @return NULL if deck is completely empty
-//
-Card* travelToTheBottom(Card* card_instance)
-{
-  if (card_instance == NULL)
-  {
-    return NULL;
-  }
-  else if ((*card_instance).next_ != NULL)
-  {
-    return travelToTheBottom((*card_instance).next_);
-  }
-  else
-  {
-    return card_instance;
-  }
-}
-
-
-
-
-//-----------------------------------------------------------------------------
-///
-/// Checks if the card we want to move can be moved with all the other cards
-/// below it.
-///
-/// @param card_instance pointer to card for which deck we want to check for
-///
-/// @return 0 if moving all cards below is permitted
-/// @return -1 if moving all cards below is not permitted
-//
-int checkCardsBelow(Card card_instance)
-{
-  if (card_instance.next_ != NULL)
-  {
-    if ((*(card_instance.next_)).color_ != card_instance.color_)
-    {
-      if ((*(card_instance.next_)).value_ == card_instance.value_ - 1)
-      {
-        return checkCardsBelow(*(card_instance.next_));
-      }
-      else
-      {
-        return -1;
-      }
-    }
-    else
-    {
-      return -1;
-    }
-  }
-  else
-  {
-    return 0;
-  }
-}
-
-
-
-
-//-----------------------------------------------------------------------------
-///
-/// At the beginning of every command prints "esp>" and awaits for the
-/// following command to be executed by the user input.
-///
-///
-/// @return move_var the number containing description of the wanted card
-/// @return 2 out of memory
-/// @return 0 if command is exit or EOF
-/// @return -1 if command is help
-/// @return -2 if command is move
-//
-int checkUserInput()
-{
-  printf("esp> ");
-  char *read_line;
-  read_line = (char *) malloc(100 * sizeof(char));
-  if (read_line == NULL)
-  {
-    free(read_line);
-    printf("[ERR] Out of memory\n");
-    return 2;
-  }
-  int i;
-  int color_var;
-  int value;
-  int move_var;
-  int length_counter = 100;
-  fgets(read_line, 100, stdin);
-  while(1)
-  {
-    if (feof(stdin) != 0)
-      return 0;
-    if (read_line[strlen(read_line) - 1] != '\n')
-    {
-      length_counter *= 2;
-      read_line = (char *) realloc(read_line, length_counter * sizeof(char));
-      if (read_line == NULL)
-      {
-        printf("[ERR] Out of memory\n");
-        free(read_line);
-        return 2;
-      }
-      fgets(&(read_line[strlen(read_line)]), 100, stdin);
-    }
-    else
-    {
-      break;
-    }
-  }
-  read_line[strlen(read_line) - 1] = ' ';
-  for (i = 0; i < strlen(read_line); i++)
-  {
-    read_line[i] = toupper(read_line[i]);
-  }
-  char** tokens;
-  tokens = (char**)malloc(7*sizeof(char*));
-  if (tokens == NULL)
-  {
-	  free(tokens);
-	  free(read_line);
-	  printf("[ERR] Out of memory\n");
-	  return 2;
-  }  
-  for (i =0; i < 7; i++)
-  {
-    tokens[i] = (char*)malloc(20*sizeof(char));
-    if (tokens[i] == NULL)
-    {
-	    free(tokens);
-	    free(read_line);
-	    printf("[ERR] Out of memory\n");
-	    return 2;
-    }  	
-  }
-  tokens[0] = strtok(read_line, " ");
-  for (i = 1; i < 5; i++)
-  {
-    tokens[i] = strtok(NULL, " ");
-    if (tokens[i] == NULL)
-    {
-      break;
-    }
-  }
-  if ((strcmp(tokens[0], "HELP") == 0) && (tokens[1] == NULL))
-  {
-    return -1;
-  }
-  else if ((strcmp(tokens[0], "EXIT") == 0) && (tokens[1] == NULL))
-  {
-    return 0;
-  }
-  if (strcmp(tokens[0], "MOVE") != 0)
-  {
-    return -2;
-  }
-  if ((strcmp(tokens[1], "BLACK") != 0) && (strcmp(tokens[1], "RED") != 0))
-  {
-    return -2;
-  }
-  if (strcmp(tokens[1], "BLACK") == 0)
-  {
-    color_var = 13;
-  }
-  else
-  {
-    color_var = 0;
-  }
-  value = checkCardValue(tokens[2]);
-  if (value == -1)
-  {
-    return -2;
-  }
-  value += color_var;
-  if (strcmp(tokens[3], "TO") != 0)
-  {
-    return -2;
-  }
-  move_var = checkDeckNumber(tokens[4]);
-  if (move_var == -1)
-  {
-    return -2;
-  }
-  else
-  {
-    move_var = (move_var * 100) + value;
-  }
-  free(tokens);
-  free(read_line);
-  return move_var;
-}
-
-
-
-
-//-----------------------------------------------------------------------------
-///
-/// Function that checks what deck number the user wants a card moved to, then
-/// returns the number of that deck
-///
-/// @param tok token containing the number we want, represented as a string
-///
-/// @return -1 if token is invalid
-/// @return number of deck that we want to move to
-//
-int checkDeckNumber(char* tok)
-{
-  if (tok[0] == '0')
-  {
-    if ((tok[1] == 10) || (tok[1] == 0) || (tok[1] == 13))
-    {
-      return 0;
-    }
-    else
-    {
-      return -1;
-    }
-  }
-  else if (tok[0] == '1')
-  {
-    if ((tok[1] == 10) || (tok[1] == 0) || (tok[1] == 13))
-    {
-      return 1;
-    }
-    else
-    {
-      return -1;
-    }
-  }
-  else if (tok[0] == '2')
-  {
-    if ((tok[1] == 10) || (tok[1] == 0) || (tok[1] == 13))
-    {
-      return 2;
-    }
-    else
-    {
-      return -1;
-    }
-  }
-  else if (tok[0] == '3')
-  {
-    if ((tok[1] == 10) || (tok[1] == 0) || (tok[1] == 13))
-    {
-      return 3;
-    }
-    else
-    {
-      return -1;
-    }
-  }
-  else if (tok[0] == '4')
-  {
-    if ((tok[1] == 10) || (tok[1] == 0) || (tok[1] == 13))
-    {
-      return 4;
-    }
-    else
-    {
-      return -1;
-    }
-  }
-  else if (tok[0] == '5')
-  {
-    if ((tok[1] == 10) || (tok[1] == 0) || (tok[1] == 13))
-    {
-      return 5;
-    }
-    else
-    {
-      return -1;
-    }
-  }
-  else if (tok[0] == '6')
-  {
-    if ((tok[1] == 10) || (tok[1] == 0) || (tok[1] == 13))
-    {
-      return 6;
-    }
-    else
-    {
-      return -1;
-    }
-  }
-  else
-  {
-    return -1;
-  }
-}
-
-
-
-//-----------------------------------------------------------------------------
-///
-/// Setting up the decks.
-/// This function is for pointing all the cards to the decks.
-/// The cards are set up as described in Palme.
-///
-/// @param deck array of pointers to the first card in every deck
-/// @param card_instance pointer to card for which deck we want to check for
-///
-//
-void setFirstPointers(Card** deck, Card* card_instance)
-{
-  deck[0] = &card_instance[0];
-  
-  deck[1] = &card_instance[25];
-  card_instance[25].prev_ = NULL;
-  card_instance[25].next_ = NULL;
-  
-  deck[2] = &card_instance[24];
-  card_instance[24].prev_ = NULL;
-  card_instance[24].next_ = &card_instance[21];
-  card_instance[21].prev_ = &card_instance[24];
-  card_instance[21].next_ = NULL;
-  
-  deck[3] = &card_instance[23];
-  card_instance[23].prev_ = NULL;
-  card_instance[23].next_ = &card_instance[20];
-  card_instance[20].prev_ = &card_instance[23];
-  card_instance[20].next_ = &card_instance[18];
-  card_instance[18].prev_ = &card_instance[20];
-  card_instance[18].next_ = NULL;
-  
-  deck[4] = &card_instance[22];
-  card_instance[22].prev_ = NULL;
-  card_instance[22].next_ = &card_instance[19];
-  card_instance[19].prev_ = &card_instance[22];
-  card_instance[19].next_ = &card_instance[17];
-  card_instance[17].prev_ = &card_instance[19];
-  card_instance[17].next_ = &card_instance[16];
-  card_instance[16].prev_ = &card_instance[17];
-  card_instance[16].next_ = NULL;
-  
-  deck[5] = NULL;
-  deck[6] = NULL;
-  
-  int i;
-
-  for (i = 0; i < 16; i++)
-  {
-    card_instance[i].prev_ = &card_instance[i - 1];
-    card_instance[i].next_ = &card_instance[i + 1];
-  }
-  card_instance[15].next_ = NULL;
-  card_instance[0].prev_ = NULL;
-}
-
-
-
-//-----------------------------------------------------------------------------
-///
-/// Function is used for checking the file validity and lines validity
-///
-/// @param config_file is a pointer to the file used with the program
-/// @param card_instance pointer to card for which deck we want to check for
-///
-/// @return 0 if file is valid;
-/// @return 2 if out of memory;
-/// @return 3 if file invalid or not found
-//
-int entireInputFromFile(FILE *config_file, Card *card_instance)
-{
-  if (config_file == NULL)
-  {
-    return 3;
-  }
-  int i;
-  int length_counter = 100;
-  char **line;
-  line = (char**)malloc(26 * sizeof(char*));
-  if (line == NULL)
-  {
-	  free(line);
-	  printf("[ERR] Out of memory\n");
-	  return 2;
-  }
-  for (i = 0; i < 26; i++)
-  {
-    line[i] = (char*)malloc(length_counter * sizeof(char));
-	  if (line == NULL)
-    {
-	    free(line);
-	    printf("[ERR] Out of memory\n");
-	    return 2;
-    }
-  }
-  for (i = 0; i < 26; i++)
-  {
-    fgets(line[i], 100, config_file);
-    while (1)
-    {
-      if (feof(config_file) != 0)
-        break;
-      if (line[i][strlen(line[i]) - 1] != '\n')
-      {
-        length_counter *= 2;
-        line[i] = (char*)realloc(line[i], length_counter * sizeof(char));
-        if (line[i] == NULL)
-        {
-          printf("[ERR] Out of memory\n");
-          free(line);
-          return 2;
-        }
-        fgets(&(line[i][strlen(line[i])]), 100, config_file);
-      }
-      else
-      {
-        break;
-      }
-    }
-    if (checkForEmptyLine(line[i]) == 0)
-    {
-      i -= 1;
-    }
-  }
-  char *token;
-  char *tok_2;
-  char *tok_3;
-  tok_3 = NULL;
-  int *value;
-  char *color;
-  value = (int*)malloc(sizeof(int));
-  if (value == NULL)
-  {
-	  free(value);
-	  free(line);
-	  printf("[ERR] Out of memory\n");
-	  return 2;
-  }
-  color = (char*)malloc(sizeof(char));
-  if (value == NULL)
-  {
-	  free(color);
-	  free(value);
-	  free(line);
-	  printf("[ERR] Out of memory\n");
-	  return 2;
-  }  
-  for (i = 0; i < 26; i++)
-  {
-    token = strtok(line[i], " ");
-    tok_2 = strtok(NULL, " ");
-    tok_3 = strtok(NULL, " ");
-    if (tok_3 != NULL)
-    {
-      if (checkForEmptyLine(tok_3) == 1)
-      {
-        return 3;
-      }
-    }
-    *color = checkCardColor(token);
-    if (*color == 'E')
-    {
-      return 3;
-    }
-    card_instance[i].color_ = *color;
-    *value = checkCardValue(tok_2);
-    if (*value == -1)
-    {
-      return 3;
-    }
-    card_instance[i].value_ = *value;
-    if (checkForSameCard(card_instance, i) == -1)
-    {
-      return 3;
-    }
-  }
-  free(line);
-  free(color);
-  free(value);
-  return 0;
-}
-
-
-
-
-//-----------------------------------------------------------------------------
-///
-/// Depending on the user input, this function checks for the card color
-///
-///
-/// @param tok used as a token (string part) in string to check for deck number
-///
-/// @return 'R' for red
-/// @return 'B' for black
-/// @return 'E' for non existing color of the card
-//
-char checkCardColor(char* tok)
-{
-  if (strcmp(tok, "RED") == 0)
-  {
-    return 'R';
-  }
-  else if (strcmp(tok, "BLACK") == 0)
-  {
-    return 'B';
-  }
-  else
-  {
-    return 'E';
-  }
-}
-
-
-//-----------------------------------------------------------------------------
-///
-/// This function checks for the same card when loaded from the file.
-///
-/// @param cards all pointers from struct Card
-/// @param i is a counter
-///
-/// @return 0
-/// @return -1
-//
-int checkForSameCard(Card *cards, int i)
-{
-  int current;
-  current = i;
-  for (; i > 0;)
-  {
-    i--;
-    if (cards[current].value_ == cards[i].value_)
-    {
-      if (cards[current].color_ == cards[i].color_)
-      {
-        return -1;
-      }
-    }
-  }
-  return 0;
-}
-
-
-
-//-----------------------------------------------------------------------------
-///
-/// Skips all the empty lines in the file.
-///
-/// @param line pointer to the line in file input
-///
-/// @return 1 successful
-/// @return 0 not successful
-//
-int checkForEmptyLine(char *line)
-{
-  int i;
-  for (i = 0; i < strlen(line); i += 1)
-  {
-    if ((line[i] != ' ') && (line[i] != '\n') && (line[i] != '\0') &&
-        (line[i] != '\t') && (line[i] != '\r') && (line[i] != 13))
-    {
-      return 1;
-    }
-  }
-  return 0;
-}
-
-
-
-//-----------------------------------------------------------------------------
-///
-/// Checks for values of the cards in the deck and returns their values.
-///
-///
-/// @param tok used as a token (string part) in string to check for deck number
-///
-/// @return -1 if wrong
-/// @return required number as the value of the card
-//
-int checkCardValue(char *tok)
-{
-  if (tok == NULL)
-  {
-    return -1;
-  }
-  if (tok[0] == '1')// this checks for 10
-  {
-    if (tok[1] == '0')
-    {
-      if ((tok[2] == 10) || (tok[2] == 0) ||  (tok[2] == 13) ||
-            (tok[2] == EOF))
-      {
-        return 10;
-      }
-      else
-      {
-        return -1;
-      }
-    }
-    else
-    {
-      return -1;
-    }
-  }
-  else if (tok[0] == '2')// this checks for 2
-  {
-    if ((tok[1] == 10) || (tok[1] == 0) ||  (tok[1] == 13) || (tok[1] == EOF))
-    {
-      return 2;
-    }
-    else
-    {
-      return -1;
-    }
-  }
-  else if (tok[0] == '3')// this checks for 3
-  {
-    if ((tok[1] == 10) || (tok[1] == 0) ||  (tok[1] == 13) || (tok[1] == EOF))
-    {
-      return 3;
-    }
-    else
-    {
-      return -1;
-    }
-  }
-  else if (tok[0] == '4')// this checks for 4
-  {
-    if ((tok[1] == 10) || (tok[1] == 0) ||  (tok[1] == 13) || (tok[1] == EOF))
-    {
-      return 4;
-    }
-    else
-    {
-      return -1;
-    }
-  }
-  else if (tok[0] == '5')// this checks for 5
-  {
-    if ((tok[1] == 10) || (tok[1] == 0) ||  (tok[1] == 13) || (tok[1] == EOF))
-    {
-      return 5;
-    }
-    else
-    {
-      return -1;
-    }
-  }
-  else if (tok[0] == '6')// this checks for 6
-  {
-    if ((tok[1] == 10) || (tok[1] == 0) ||  (tok[1] == 13) || (tok[1] == EOF))
-    {
-      return 6;
-    }
-    else
-    {
-      return -1;
-    }
-  }
-  else if (tok[0] == '7')// this checks for 7
-  {
-    if ((tok[1] == 10) || (tok[1] == 0) ||  (tok[1] == 13) || (tok[1] == EOF))
-    {
-      return 7;
-    }
-    else
-    {
-      return -1;
-    }
-  }
-  else if (tok[0] == '8')// this checks for 8
-  {
-    if ((tok[1] == 10) || (tok[1] == 0) ||  (tok[1] == 13) || (tok[1] == EOF))
-    {
-      return 8;
-    }
-    else
-    {
-      return -1;
-    }
-  }
-  else if (tok[0] == '9')// this checks for 9
-  {
-    if ((tok[1] == 10) || (tok[1] == 0) ||  (tok[1] == 13) || (tok[1] == EOF))
-    {
-      return 9;
-    }
-    else
-    {
-      return -1;
-    }
-  }
-  else if (tok[0] == 'A')// this checks for Ace
-  {
-    if ((tok[1] == 10) || (tok[1] == 0) ||  (tok[1] == 13) || (tok[1] == EOF))
-    {
-      return 1;
-    }
-    else
-    {
-      return -1;
-    }
-  }
-  else if (tok[0] == 'J')// this checks for Jack
-  {
-    if ((tok[1] == 10) || (tok[1] == 0) ||  (tok[1] == 13) || (tok[1] == EOF))
-    {
-      return 11;
-    }
-    else
-    {
-      return -1;
-    }
-  }
-  else if (tok[0] == 'Q')// this checks for Queen
-  {
-    if ((tok[1] == 10) || (tok[1] == 0) ||  (tok[1] == 13) || (tok[1] == EOF))
-    {
-      return 12;
-    }
-    else
-    {
-      return -1;
-    }
-  }
-  else if (tok[0] == 'K')// this checks for King
-  {
-    if ((tok[1] == 10) || (tok[1] == 0) ||  (tok[1] == 13) || (tok[1] == EOF))
-    {
-      return 13;
-    }
-    else
-    {
-      return -1;
-    }
-  }
-  else
-  {
-    return -1;
-  }
-}
-
+//-----------------------------------------------------------------------------
+//
+// A simplified Solitaire game. The game is controlled/played via the command
+// line console, and the game is set up by calling the main function alongside
+// a file which contains the order of the cards, as described on Palme.
+// The game ends once all cards have been moved to deposit decks, or the user
+// enters "exit\n", or EOF. The rules are the same as in regular solitaire.
+// There are only 2 types of cards, reds and blacks, each has 13 instances.
+// Each card is unique.
+//
+// Build with: gcc -O2 -pthread -o solitaire solitaire.c
+// The game itself can be used as a library, see solitaire.h.
+//
+//-----------------------------------------------------------------------------
+//
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <errno.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include "solitaire.h"
+
+// Number of malloc and calloc calls, and of realloc calls, made by the game,
+// for the benchmarks and --stats. The macros only count, the calls themselves
+// are the usual ones. The library build has neither, so there the counters
+// stay 0 and allocating costs nothing extra.
+atomic_long allocation_count;
+atomic_long reallocation_count;
+
+// Zobrist keys of every card number at every deck and depth, and at every
+// depth of any deck, filled once by initPositionKeys.
+unsigned long long position_keys[26][7][26];
+unsigned long long depth_keys[26][26];
+pthread_once_t position_keys_once = PTHREAD_ONCE_INIT;
+
+// The tablebase given with --tablebase or NULL. Every search looks the
+// positions it reaches up in it, see probeTablebase.
+struct _Tablebase_ *tablebase;
+
+// The cache of solved deals given with --cache or NULL, see findCachedDeal.
+struct _DealCache_ *deal_cache;
+
+#ifndef SOLITAIRE_LIBRARY
+#define malloc(size) (atomic_fetch_add_explicit(&allocation_count, 1, \
+                      memory_order_relaxed), malloc(size))
+#define calloc(count, size) (atomic_fetch_add_explicit(&allocation_count, 1, \
+                             memory_order_relaxed), calloc(count, size))
+#define realloc(pointer, size) (atomic_fetch_add_explicit( \
+                                &reallocation_count, 1, \
+                                memory_order_relaxed), realloc(pointer, size))
+#endif
+
+
+struct _Card_
+{
+  char color_;
+  int value_;
+  int deck_;
+  int depth_;
+  struct _Card_ *prev_;
+  struct _Card_ *next_;
+};
+typedef struct _Card_ Card;
+
+// First and last card of every deck, and every card by its number
+// (value - 1 for red, value + 12 for black). deck_ and depth_ of the cards
+// and the tails are kept up to date by moveCards. hash_ is the Zobrist hash
+// of the position, the xor of position_keys of every card at its deck and
+// depth, moveCards changes it only for the moved cards. deck_hash_ is the
+// same for every deck by itself with depth_keys, which do not depend on the
+// deck, so canonicalHash can fold decks that are alike.
+struct _Board_
+{
+  Card *deck_[7];
+  Card *tail_[7];
+  Card *index_[26];
+  unsigned long long hash_;
+  unsigned long long deck_hash_[7];
+};
+typedef struct _Board_ Board;
+
+#define KEY_SIZE 34
+#define VISITED_START_SIZE 4096
+#define TABLE_BITS 20
+#define TABLE_WAYS 4
+#define TABLE_DEPTH_MASK 0xffffULL
+#define TABLE_LOCKS 1024
+#define MAX_SEARCH_DEPTH 0xfffe
+#define MAX_THREADS 256
+#define PATH_BLOCK_SIZE 4096
+#define ARENA_BLOCK_SIZE 65536
+#define ARENA_ALIGNMENT 16
+#define LINE_SIZE 256
+#define DEAL_MAGIC "SOLDEAL1"
+#define DEAL_MAGIC_SIZE 8
+#define DEAL_SIZE 26
+#define DEAL_MASK ((1UL << 26) - 1)
+#define DEAL_RANK_HIGH 21862473ULL
+#define TABLEBASE_MAGIC "SOLTBAS1"
+#define TABLEBASE_HEADER_SIZE 16
+#define TABLEBASE_CARDS 6
+#define TABLEBASE_MAX_CARDS 8
+#define TABLEBASE_MOVES 254
+#define CACHE_MAGIC "SOLCACH1"
+#define CACHE_HEADER_SIZE 8
+#define CACHE_RECORD_SIZE 29
+#define CACHE_SLOTS 1024
+#define CACHE_MAX_MOVES 0xffff
+#define CACHE_MAP_SIZE 1048576
+#define STATS_PARSE 0
+#define STATS_VALIDATE 1
+#define STATS_APPLY 2
+#define STATS_RENDER 3
+#define STATS_PHASES 4
+#define STATS_BUCKETS 40
+#define BENCH_DEALS 1000
+#define BENCH_CHECKPOINTS 4
+#define BENCH_STEPS 5
+#define BENCH_TIME 200000000LL
+#define BENCH_SAMPLES 65536
+#define SELFTEST_PERFT_DEAL 226
+#define SELFTEST_PERFT_DEPTH 10
+#define SELFTEST_SOLVE_DEALS 200
+#define SELFTEST_THREADS 4
+#define SERVER_EVENTS 256
+#define SWEEP_QUEUE_SIZE 256
+#define SWEEP_WINDOW 1024
+#define REPLY_SIZE (FRAME_SIZE + LINE_SIZE)
+#define HINT_SEARCHING -1
+#define ROLLOUT_PLAYOUTS 2000
+#define ROLLOUT_MOVES 300
+#define ROLLOUT_SEEN 1024
+#define ROLLOUT_CHUNK 16
+#define ROLLOUT_TIME 1000000000LL
+#define HELP_TEXT "possible command:\n" \
+                  " - move <color> <value> to <stacknumber>\n" \
+                  " - undo\n" \
+                  " - redo\n" \
+                  " - solve\n" \
+                  " - hint\n" \
+                  " - rank\n" \
+                  " - help\n" \
+                  " - exit\n"
+
+// Links of all cards and decks stored as indices into card_instance, so a
+// position can be put back after the solver tried a move.
+struct _Snapshot_
+{
+  signed char prev_[26];
+  signed char next_[26];
+  signed char deck_[7];
+};
+typedef struct _Snapshot_ Snapshot;
+
+// A block of an arena, used_ of its size_ bytes are handed out.
+struct _ArenaBlock_
+{
+  struct _ArenaBlock_ *next_;
+  size_t size_;
+  size_t used_;
+  _Alignas(ARENA_ALIGNMENT) unsigned char memory_[];
+};
+typedef struct _ArenaBlock_ ArenaBlock;
+
+// Memory that is handed out piece by piece and given back all at once by
+// resetArena. The blocks stay allocated after a reset, so work that is
+// repeated needs no more malloc calls once the arena is big enough.
+// current_ is the block allocations are made from, the blocks after it are
+// empty.
+struct _Arena_
+{
+  ArenaBlock *first_;
+  ArenaBlock *current_;
+};
+typedef struct _Arena_ Arena;
+
+// Open addressed hash set of already searched positions. hashes_ holds the
+// board hash of every key, so most slots are passed without comparing keys
+// and the table can grow without hashing the keys again. With an arena_
+// the table is allocated there and never freed by itself.
+struct _VisitedTable_
+{
+  unsigned char *keys_;
+  unsigned long long *hashes_;
+  size_t size_;
+  size_t count_;
+  Arena *arena_;
+};
+typedef struct _VisitedTable_ VisitedTable;
+
+// Winning move list, every move is a move_var as built by checkUserInput.
+// moves_ is in arena_ if that is not NULL, see freeSolution.
+struct _Solution_
+{
+  int *moves_;
+  int length_;
+  int capacity_;
+  Arena *arena_;
+};
+typedef struct _Solution_ Solution;
+
+// A move made in the game: the move_var and the deck the card came from.
+struct _JournalEntry_
+{
+  int move_var_;
+  int from_deck_;
+};
+typedef struct _JournalEntry_ JournalEntry;
+
+// All moves made so far, the first position_ of them are on the board.
+// The ones after position_ were undone and can be redone until the next
+// move is made. entries_ is in the arena of the game.
+struct _Journal_
+{
+  JournalEntry *entries_;
+  int length_;
+  int position_;
+  int capacity_;
+};
+typedef struct _Journal_ Journal;
+
+// What --stats collects over all games. Every phase of a command has a
+// histogram of its latency, bucket b counts the times from 2^b to
+// 2^(b+1) - 1 ns (bucket 0 also counts 0). rejected_ counts the invalid
+// moves by the rule they broke, MOVE_STOCK_COVERED - code. The allocation
+// counters are read when the stats start, so only the difference is shown.
+struct _Stats_
+{
+  int json_;
+  long histogram_[STATS_PHASES][STATS_BUCKETS];
+  long long total_ns_[STATS_PHASES];
+  long valid_moves_;
+  long rejected_[MOVE_RULES];
+  long invalid_commands_;
+  long nothing_to_undo_;
+  long allocations_;
+  long reallocations_;
+};
+typedef struct _Stats_ Stats;
+
+// Searches the position of an interactive game on its own thread while the
+// player thinks, see hintWorkerFunction. The fields before stop_ are only
+// used by the thread, stop_ makes it drop its search and the fields after
+// it are guarded by lock_. Every new position gets a new generation_.
+// result_ is HINT_SEARCHING or what solveGame returns for position_, and
+// with 1 line_ holds the winning moves, of which line_position_ were played
+// since. guess_ is the move to the position with the most cards on the
+// deposit decks searched so far, shown until the search is done.
+struct _HintEngine_
+{
+  pthread_t thread_;
+  Card card_instance_[26];
+  Board board_;
+  Arena arena_;
+  int searching_;
+  int best_deposited_;
+  atomic_int stop_;
+  pthread_mutex_t lock_;
+  pthread_cond_t wake_;
+  Snapshot position_;
+  int generation_;
+  int searched_;
+  int result_;
+  Solution line_;
+  int line_position_;
+  int guess_;
+  int quit_;
+};
+typedef struct _HintEngine_ HintEngine;
+
+// Playouts of every legal move of a position, see rankMoves. Playout i
+// plays moves_[i % count_] and then random moves, so stopping at any time
+// leaves all moves with about as many playouts. next_ is the next playout
+// to hand out, a thread takes ROLLOUT_CHUNK at a time until all are taken
+// or the clock passes deadline_.
+struct _Rollout_
+{
+  Snapshot root_;
+  Card card_instance_[26];
+  int moves_[MAX_MOVES];
+  int count_;
+  long playouts_;
+  long long deadline_;
+  unsigned long long seed_;
+  atomic_long next_;
+  atomic_long wins_[MAX_MOVES];
+  atomic_long played_[MAX_MOVES];
+};
+typedef struct _Rollout_ Rollout;
+
+// Everything about one game: the cards, the decks, the moves made so far and
+// how many moves and invalid commands there were. The board points into
+// card_instance_, so a game can not be copied. arena_ holds the journal and
+// is reset when the game starts again.
+struct _Game_
+{
+  Card card_instance_[26];
+  Board board_;
+  Arena arena_;
+  Journal journal_;
+  int moves_;
+  int invalid_;
+};
+
+// Where the commands of a game come from and whether anything is printed.
+// Batch games are quiet and only count what happened. threads_ is the
+// number of threads the solve command uses. Every command is read into
+// line_ and split there. stats_ is NULL unless --stats was given. With
+// sections_ the input holds the commands of several deals, a line starting
+// with '#' ends the commands of one deal and sets section_end_. scratch_
+// is for memory a command needs only while it runs, it is reset after
+// every command. hint_ is NULL unless hints are searched in the background.
+struct _Session_
+{
+  FILE *input_;
+  int quiet_;
+  int threads_;
+  char line_[LINE_SIZE];
+  Stats *stats_;
+  int sections_;
+  int section_end_;
+  Arena scratch_;
+  HintEngine *hint_;
+};
+typedef struct _Session_ Session;
+
+// A text file or stdin with any number of deals, read one deal ahead so
+// the reader knows whether the deal it got was the last one. Deals are
+// separated by empty lines or header lines starting with '#', and each is
+// read as readDealText reads a deal file, see readDealLines. next_ holds the deal after the one read last
+// and next_result_ what readDealLines returned for it. deals_ counts the
+// deals handed out.
+struct _DealStream_
+{
+  FILE *file_;
+  char line_[LINE_SIZE];
+  Card next_[26];
+  int next_result_;
+  long deals_;
+};
+typedef struct _DealStream_ DealStream;
+
+// A memory mapped file of binary deals. The file starts with DEAL_MAGIC,
+// then every deal is DEAL_SIZE bytes, the numbers of the cards (as from
+// getCardNumber) in the order entireInputFromFile reads them.
+struct _DealFile_
+{
+  unsigned char *data_;
+  size_t size_;
+  size_t count_;
+};
+typedef struct _DealFile_ DealFile;
+
+// An endgame tablebase, see buildTablebase. data_ is the mapped file,
+// table_ the byte of every position with at most cards_ cards outside the
+// deposit decks, by rankEndgame: 0 if it can not be won, n + 1 if it can be
+// won in n moves and no less.
+struct _Tablebase_
+{
+  unsigned char *data_;
+  size_t size_;
+  const unsigned char *table_;
+  int cards_;
+};
+typedef struct _Tablebase_ Tablebase;
+
+// A position of the tablebase. red_ and black_ are the numbers of red and
+// black cards on the deposit decks, it does not matter on which deck each
+// color is. cards_ holds the count_ other cards by number (see
+// getCardNumber), deck 0 first, and length_ the number of them on every
+// deck from 0 to 4, each deck from its top card to its bottom card.
+struct _EndgamePosition_
+{
+  int red_;
+  int black_;
+  int count_;
+  int length_[5];
+  unsigned char cards_[TABLEBASE_MAX_CARDS];
+};
+typedef struct _EndgamePosition_ EndgamePosition;
+
+// A file of solved deals, CACHE_MAGIC and then one record per deal: the
+// DEAL_SIZE card numbers, 1 if it can be won or 0, the number of moves in
+// two bytes and the moves in two bytes each, low byte first. Records are
+// only ever appended. data_ maps mapped_ bytes, more than the file holds,
+// and the first size_ bytes are whole records. slots_ is an open addressing
+// table of their offsets by hashDeal, 0 is an empty slot. reported_ is 1
+// once a record could not be written, see reportCacheFailure. lock_ guards
+// all of it between threads, and flock on file_ between processes.
+struct _DealCache_
+{
+  int file_;
+  unsigned char *data_;
+  size_t mapped_;
+  size_t size_;
+  size_t *slots_;
+  size_t capacity_;
+  size_t count_;
+  int reported_;
+  pthread_mutex_t lock_;
+};
+typedef struct _DealCache_ DealCache;
+
+// A word of a command and the number checkUserInput turns it into.
+struct _Keyword_
+{
+  const char *word_;
+  int code_;
+};
+typedef struct _Keyword_ Keyword;
+
+// One move of a path in the parallel search. Nodes are shared by all
+// positions below them and live until the search is over.
+struct _PathNode_
+{
+  int move_;
+  struct _PathNode_ *parent_;
+};
+typedef struct _PathNode_ PathNode;
+
+struct _PathBlock_
+{
+  PathNode nodes_[PATH_BLOCK_SIZE];
+  int used_;
+  struct _PathBlock_ *next_;
+};
+typedef struct _PathBlock_ PathBlock;
+
+// A position waiting to be searched by the parallel solver.
+struct _Task_
+{
+  Snapshot position_;
+  PathNode *path_;
+  int depth_;
+};
+typedef struct _Task_ Task;
+
+// Fixed size table of the positions the parallel solver reached, shared by
+// all threads. Every entry is the hash of the position (see canonicalHash)
+// with the low 16 bits replaced by the depth + 1 it was reached at, 0 is an
+// empty entry, and keys_ holds the key of the position (see encodePosition)
+// at the same index. An entry goes into one of the TABLE_WAYS entries of the
+// bucket chosen by the low bits of the hash. The buckets are guarded by
+// TABLE_LOCKS locks, bucket i by lock i % TABLE_LOCKS.
+struct _PositionTable_
+{
+  unsigned long long *entries_;
+  unsigned char *keys_;
+  pthread_mutex_t *locks_;
+  size_t buckets_;
+};
+typedef struct _PositionTable_ PositionTable;
+
+struct _ParallelSearch_;
+
+// A solver thread. The owner pushes and pops tasks at the end of its deque,
+// other workers steal from the front, where the biggest subtrees are.
+struct _Worker_
+{
+  pthread_t thread_;
+  pthread_mutex_t lock_;
+  Task *tasks_;
+  int first_;
+  int count_;
+  int capacity_;
+  Card card_instance_[26];
+  Board board_;
+  PathBlock *blocks_;
+  struct _ParallelSearch_ *search_;
+  int id_;
+};
+typedef struct _Worker_ Worker;
+
+// State shared by all solver threads. The reached positions are in the
+// shared table_. pending_ counts tasks that are queued or being searched, the
+// search is over when it drops to 0. result_ is 1 once a win was found and
+// 2 if a thread ran out of memory.
+struct _ParallelSearch_
+{
+  Worker *workers_;
+  int count_;
+  PositionTable table_;
+  atomic_long pending_;
+  atomic_int result_;
+  Solution *solution_;
+  pthread_mutex_t solution_lock_;
+};
+typedef struct _ParallelSearch_ ParallelSearch;
+
+// What the benchmarks run over: the deals as text and as cards, a command
+// script, positions reached by playing scripted moves from every deal and
+// the moves the rule checks are asked about (position * 1000 + move_var).
+// Deal i of the text starts at text_offsets_[i] and text_files_[i] reads
+// only that deal.
+struct _BenchCorpus_
+{
+  int deals_;
+  Card (*deal_cards_)[26];
+  char *text_;
+  size_t text_length_;
+  size_t *text_offsets_;
+  FILE **text_files_;
+  char *script_;
+  size_t script_length_;
+  int script_lines_;
+  Session session_;
+  int positions_;
+  Card (*cards_)[26];
+  Board *boards_;
+  int *tableau_moves_;
+  int tableau_count_;
+  int *deposit_moves_;
+  int deposit_count_;
+  Card scratch_cards_[26];
+  Board scratch_board_;
+};
+typedef struct _BenchCorpus_ BenchCorpus;
+
+// One benchmarked function. function_ does one operation on element index
+// of the corpus, there are operations_ elements. The results are filled in
+// by runBenchmark, latency_ holds the 50th, 90th and 99th percentile and the
+// maximum in ns.
+struct _Benchmark_
+{
+  const char *name_;
+  long (*function_)(BenchCorpus* corpus, long index);
+  long operations_;
+  double ns_per_op_;
+  double allocations_per_op_;
+  long latency_[4];
+};
+typedef struct _Benchmark_ Benchmark;
+
+// A deal on its way through the sweep, see mainSweepFunction. sequence_
+// is its place in the output, file_ the argument it came from and deal_ its
+// number in a binary deal file or -1 for a deal file. The solver fills in
+// result_ as solveGame returns it, or 3 for an invalid deal, and moves_.
+struct _SweepJob_
+{
+  long sequence_;
+  int file_;
+  long deal_;
+  unsigned char cards_[DEAL_SIZE];
+  int result_;
+  int moves_;
+};
+typedef struct _SweepJob_ SweepJob;
+
+// A cell of a SweepQueue. sequence_ tells whose turn it is: the cell can be
+// written by the push at position sequence_ and read by the pop at position
+// sequence_ - 1.
+struct _SweepCell_
+{
+  atomic_size_t sequence_;
+  SweepJob job_;
+};
+typedef struct _SweepCell_ SweepCell;
+
+// Bounded lock free queue of jobs for any number of threads on both ends.
+// A push or pop claims a position with compare and swap on tail_ or head_,
+// which are on their own cache lines.
+struct _SweepQueue_
+{
+  SweepCell *cells_;
+  size_t mask_;
+  _Alignas(64) atomic_size_t head_;
+  _Alignas(64) atomic_size_t tail_;
+};
+typedef struct _SweepQueue_ SweepQueue;
+
+// The three stages of a sweep and the queues between them. read_ counts the
+// jobs the reader made, reading_ is 1 until it made the last one. written_
+// counts the lines the writer printed, the reader waits while it is
+// SWEEP_WINDOW behind. stop_ ends all stages early.
+struct _Sweep_
+{
+  char **paths_;
+  int count_;
+  SweepQueue deals_;
+  SweepQueue results_;
+  atomic_long read_;
+  atomic_int reading_;
+  atomic_long written_;
+  atomic_int stop_;
+};
+typedef struct _Sweep_ Sweep;
+
+// A player connected to the server. Until cards_ reaches 26 the lines are
+// the deal, after that they are commands. Input is read into input_ and
+// taken line by line, a line longer than LINE_SIZE is cut like fgets cuts
+// it and the rest of it is skipped. The reply to a command is kept in
+// reply_ until the socket took all of it, no further line is taken before.
+// closing_ is set once the game is over, the connection is closed when the
+// reply was sent.
+struct _Connection_
+{
+  int socket_;
+  unsigned int events_;
+  Game *game_;
+  int cards_;
+  unsigned long mask_;
+  char input_[LINE_SIZE];
+  int input_length_;
+  int skipping_;
+  char reply_[REPLY_SIZE];
+  int reply_length_;
+  int reply_sent_;
+  int closing_;
+};
+typedef struct _Connection_ Connection;
+
+// The event loop of the server. accepting_ is 0 while no more files can be
+// opened, the listening socket is watched again once a connection closed.
+struct _Server_
+{
+  int epoll_;
+  int listener_;
+  int accepting_;
+  long connections_;
+};
+typedef struct _Server_ Server;
+
+//Forward declarations
+int checkCardValue(char *tok);
+int checkForEmptyLine(const char *line, size_t length);
+void setFirstPointers(Board* board, Card* card_instance);
+void indexBoard(Board* board, Card* card_instance);
+void initPositionKeys(void);
+unsigned long long mixHash(unsigned long long hash);
+unsigned long long canonicalHash(Board* board);
+char checkCardColor(char* tok);
+int entireInputFromFile(FILE *config_file, Card *card_instance);
+int checkDeckNumber(char* tok);
+int checkUserInput(Session* session);
+int readUserInput(Session* session);
+int findKeyword(const Keyword* keywords, int count, char* tok);
+int checkCardsBelow(Card card_instance);
+Card* travelToTheBottom(Board* board, int deck_number);
+int checkForValidMove(Board* board, Card *wanted_card, int desired_deck);
+int checkMoveForDeposit(Board* board, Card* wanted_card, int desired_deck);
+void moveCards(Board* board, Card* wanted_card, int current_deck,
+               int desired_deck);
+int travelToTheTop(Card *card_instance);
+Card* findCardFromMoveVar(int move_var, Board* board);
+int mainPrintFunction(Card** deck);
+int renderBoard(Card** deck, char* frame);
+int getCardNumber(Card* card);
+int mainOptionsFunction(int argc, char *argv[], Tablebase* endgames,
+                        DealCache* cache);
+int mainGameFunction(Game* game, Session* session);
+int mainBatchFunction(int count, char** paths, Stats* stats);
+int batchGameFunction(char* deal_name, Game* game, Stats* stats);
+int selectDealFile(const struct dirent* entry);
+int checkForWin(Board* board);
+void startGame(Game* game);
+int checkGameMove(Game* game, int move_var);
+int playGameMove(Game* game, int move_var);
+int readDealText(const char* text, size_t length, Card* card_instance);
+int readDealLine(const char* line, size_t length, Card* card);
+int decodeDeal(const unsigned char* deal, Card* card_instance);
+int makeMove(Board* board, Card* wanted_card, int current_deck,
+             int desired_deck);
+int checkMove(Board* board, Card* wanted_card, int current_deck,
+              int desired_deck);
+int generateMoves(Board* board, int* moves);
+void unmakeMove(Board* board, Card* wanted_card, int from_deck);
+int recordMove(Journal* journal, Arena* arena, int move_var, int from_deck);
+int undoMove(Board* board, Journal* journal);
+int redoMove(Board* board, Journal* journal);
+void saveSnapshot(Board* board, Card* card_instance, Snapshot* snapshot);
+void restoreSnapshot(Board* board, Card* card_instance, Snapshot* snapshot);
+void encodePosition(Board* board, Card* card_instance, unsigned char* key);
+int insertPosition(VisitedTable* visited, unsigned char* key,
+                   unsigned long long hash);
+int searchPosition(Board* board, Card* card_instance, VisitedTable* visited,
+                   Solution* solution, int depth);
+int solveGame(Board* board, Card* card_instance, Solution* solution,
+              Arena* arena);
+int solveFromPosition(Board* board, Card* card_instance, int threads,
+                      Arena* arena);
+void freeSolution(Solution* solution);
+int listCandidateMoves(Board* board, int* moves);
+int solveGameParallel(Board* board, Card* card_instance, Solution* solution,
+                      int threads);
+void* parallelWorkerFunction(void* argument);
+int expandTask(Worker* worker, Task* task);
+int pushTask(Worker* worker, Task* task);
+int popTask(Worker* worker, Task* task);
+int stealTask(Worker* worker, Task* task);
+int probePosition(PositionTable* table, unsigned char* key,
+                  unsigned long long hash, int depth);
+PathNode* newPathNode(Worker* worker, int move_var, PathNode* parent);
+void printMoveCommand(int move_var);
+int formatMoveCommand(int move_var, char* command);
+int mainBenchFunction(int count, char** args);
+int buildBenchCorpus(BenchCorpus* corpus, int deals);
+void addBenchPosition(BenchCorpus* corpus, Board* board,
+                      Card* card_instance);
+void freeBenchCorpus(BenchCorpus* corpus);
+void runBenchmark(BenchCorpus* corpus, Benchmark* bench, long* samples);
+long long readClock(void);
+int compareLatency(const void* first, const void* second);
+long benchNothing(BenchCorpus* corpus, long index);
+long benchEntireInputFromFile(BenchCorpus* corpus, long index);
+long benchSetFirstPointers(BenchCorpus* corpus, long index);
+long benchCheckUserInput(BenchCorpus* corpus, long index);
+long benchCheckForValidMove(BenchCorpus* corpus, long index);
+long benchCheckMoveForDeposit(BenchCorpus* corpus, long index);
+long benchTravelToTheTop(BenchCorpus* corpus, long index);
+long benchTravelToTheBottom(BenchCorpus* corpus, long index);
+long benchMainPrintFunction(BenchCorpus* corpus, long index);
+int solveDeal(Board* board, Card* card_instance, Solution* solution,
+              int threads, Arena* arena);
+int convertDealFiles(int count, char** paths);
+int openDealFile(char* path, DealFile* deals);
+void closeDealFile(DealFile* deals);
+int loadDeal(DealFile* deals, size_t number, Card* card_instance);
+void encodeDeal(Card* card_instance, unsigned char* deal);
+int solveDealFile(DealFile* deals, char* deal_name, int threads);
+int openDealStream(DealStream* stream, char* path);
+void closeDealStream(DealStream* stream);
+int readStreamDeal(DealStream* stream, Card* card_instance);
+int readDealLines(DealStream* stream, Card* card_instance);
+int solveDealStream(char* deal_name, int threads);
+void skipScriptSection(Session* session);
+void* allocateArena(Arena* arena, size_t size);
+void resetArena(Arena* arena);
+void freeArena(Arena* arena);
+int startHintEngine(HintEngine* hint, Game* game);
+void stopHintEngine(HintEngine* hint);
+void updateHint(HintEngine* hint, Game* game, int move_var);
+void printHint(HintEngine* hint);
+void* hintWorkerFunction(void* argument);
+int searchHint(HintEngine* hint, VisitedTable* visited, Solution* path,
+               int depth);
+int rankMoves(Board* board, Card* card_instance, Rollout* rollout);
+void* rolloutWorkerFunction(void* argument);
+int playRollout(Board* board, unsigned long long seed,
+                unsigned long long* seen);
+int checkSeenPosition(unsigned long long* seen, unsigned long long hash,
+                      int insert);
+void printMoveRanking(Rollout* rollout);
+int mainPerftFunction(Game* game, int depth, int split);
+unsigned long long countMoveSequences(Board* board, int depth,
+                                      unsigned long long* made);
+int mainSelftestFunction(void);
+int checkPerftCounts(void);
+int checkEndgameRanks(void);
+int checkParallelSolve(void);
+int buildTablebase(char* path, int cards);
+int markPredecessors(unsigned char* table, int cards,
+                     EndgamePosition* position, int value);
+int openTablebase(char* path, Tablebase* table);
+void closeTablebase(Tablebase* table);
+int probeTablebase(Board* board);
+int followTablebase(Board* board, int* moves);
+int readEndgame(Board* board, EndgamePosition* position);
+unsigned long long rankEndgame(EndgamePosition* position);
+void unrankEndgame(unsigned long long rank, EndgamePosition* position);
+unsigned long long countEndgames(int cards);
+unsigned long long countCombinations(int count, int chosen);
+int reserveSolution(Solution* solution, int length);
+int openDealCache(char* path, DealCache* cache);
+void closeDealCache(DealCache* cache);
+int findCachedDeal(DealCache* cache, Card* card_instance, Solution* solution,
+                   Arena* arena);
+int storeCachedDeal(DealCache* cache, Card* card_instance, int result,
+                    Solution* solution);
+void reportCacheFailure(DealCache* cache);
+int indexCachedDeals(DealCache* cache);
+size_t lookupCachedDeal(DealCache* cache, unsigned char* deal);
+int insertCachedDeal(DealCache* cache, size_t offset);
+unsigned long long hashDeal(const unsigned char* deal);
+int checkDealStart(Board* board, Card* card_instance);
+void setCardNumber(Card* card, int number);
+void generateDeal(unsigned long long deal_number, Card* card_instance);
+int readDealNumber(char* tok, unsigned long long* deal_number);
+int generateDealFiles(int count, char** paths);
+void printDeal(FILE* deal_file, Card* card_instance);
+void startStats(Stats* stats, int json);
+long long startPhase(Stats* stats);
+void endPhase(Stats* stats, int phase, long long start);
+void printStats(Stats* stats, FILE* output);
+void printPhaseStats(Stats* stats, int phase, FILE* output);
+int mainServerFunction(char* socket_path);
+int mainSweepFunction(int count, char** paths, int threads);
+void* sweepReaderFunction(void* argument);
+void* sweepSolverFunction(void* argument);
+int initSweepQueue(SweepQueue* queue, size_t size);
+int pushSweepJob(SweepQueue* queue, SweepJob* job);
+int popSweepJob(SweepQueue* queue, SweepJob* job);
+int queueSweepJob(Sweep* sweep, SweepQueue* queue, SweepJob* job);
+void printSweepJob(Sweep* sweep, SweepJob* job);
+void acceptConnections(Server* server);
+void serveConnection(Server* server, Connection* connection,
+                     unsigned int events);
+void closeConnection(Server* server, Connection* connection);
+int takeLine(Connection* connection, char* line);
+void serveDealLine(Connection* connection, char* line);
+void serveCommand(Connection* connection, char* line);
+void addReply(Connection* connection, const char* text, int length);
+int sendReply(Connection* connection);
+
+
+
+
+
+
+
+
+#ifndef SOLITAIRE_LIBRARY
+//-----------------------------------------------------------------------------
+///
+/// The main program.
+/// Main function opens a file a reads the input. Errors are executed
+/// in case of invalid file or invalid file name. Memory is allocated
+/// for the game, which holds the 26 cards and the 7 decks. When the board
+/// is printed we enter the while loop in order to start printing our cards
+/// on the board. While the game waits for commands a thread searches the
+/// position for the "hint" command, see HintEngine. "rank" estimates how
+/// often every move wins with random playouts, see rankMoves.
+///
+/// With "--solve" in front of the file name the game is not played, instead
+/// it is reported whether the deal can be won and how. "--threads <n>" sets
+/// the number of threads used for solving.
+///
+/// With "--batch" any number of deal files or directories of deal files
+/// follow, each is played with its command script without printing.
+///
+/// With "--convert" the deal files after the first file name are written
+/// to it as binary deals. If the file name of a game is such a file, its
+/// first deal is played, and with "--solve" every deal in it is solved.
+///
+/// "--bench [deals]" times the engine functions over that many generated
+/// deals, see mainBenchFunction.
+///
+/// "--stats text|json" in front of a game or "--batch" times every command
+/// and counts the moves, and prints that to stderr in the end. There are no
+/// commands to time with "--solve", "--sweep" or "--perft", so it is not
+/// accepted with them.
+///
+/// "--deal <number>" takes the generated deal with that number instead of
+/// a file. "--generate <number> <count>" prints count generated deals
+/// starting with number, or writes them as binary deals if a file name
+/// follows.
+///
+/// "--serve <socket-path>" hosts any number of games on a Unix domain
+/// socket, see mainServerFunction.
+///
+/// "--sweep" solves every deal of any number of deal files and binary deal
+/// files, reading, solving and printing at the same time on "--threads"
+/// solver threads, see mainSweepFunction.
+///
+/// "--perft <depth>" counts the move sequences of that length from the
+/// deal, with "--split" for every first move, see mainPerftFunction.
+///
+/// "--selftest" checks the engine against known results, see
+/// mainSelftestFunction.
+///
+/// "--build-tablebase <file> [cards]" writes the endgame tablebase of all
+/// positions with up to cards cards outside the deposit decks, see
+/// buildTablebase. "--tablebase <file>" in front of the other options lets
+/// every search stop once it reaches such a position, see probeTablebase.
+///
+/// "--cache <file>" in front of the other options keeps every deal solved
+/// from its start in that file, and a deal found there is not solved again,
+/// see DealCache.
+///
+/// With "--solve", "--batch" and "--sweep" a deal file may hold any number
+/// of deals, and "-" reads them from stdin, see DealStream. They are read
+/// one at a time.
+///
+/// @param argc used to check is program called with exactly one extra
+/// argument after the options
+/// @param argv used to access a input file
+///
+/// @return 0 if program was ran successfully
+/// @return 1 if no file name was given to the run of the program, or a
+/// check of "--selftest" failed
+/// @return 2 if out of memory
+/// @return 3 if invalid file
+//
+int main(int argc, char *argv[])
+{
+  int err_var;
+  Tablebase endgames;
+  DealCache cache;
+  err_var = mainOptionsFunction(argc, argv, &endgames, &cache);
+  if (deal_cache != NULL)
+  {
+    closeDealCache(deal_cache);
+  }
+  if (tablebase != NULL)
+  {
+    closeTablebase(tablebase);
+  }
+  return err_var;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Reads the options and runs what they ask for, see main. Every way out
+/// returns here, so main releases the tablebase and the cache once.
+///
+/// @param argc number of arguments
+/// @param argv the arguments
+/// @param endgames room for the tablebase of "--tablebase"
+/// @param cache room for the cache of "--cache"
+///
+/// @return what main returns
+//
+int mainOptionsFunction(int argc, char *argv[], Tablebase* endgames,
+                        DealCache* cache)
+{
+  int solve_only = 0;
+  int generated = 0;
+  int split = 0;
+  unsigned long long perft_depth = 0;
+  int perft = 0;
+  unsigned long long tablebase_cards = TABLEBASE_CARDS;
+  int err_var;
+  Stats stats;
+  HintEngine hint;
+  unsigned long long deal_number = 0;
+  int arg = 1;
+  Session session = {.input_ = stdin, .quiet_ = 0, .threads_ = 1};
+  while ((arg < argc) && (strncmp(argv[arg], "--", 2) == 0))
+  {
+    if ((strcmp(argv[arg], "--batch") == 0) && (arg < argc - 1))
+    {
+      return mainBatchFunction(argc - arg - 1, &argv[arg + 1],
+                               session.stats_);
+    }
+    else if ((strcmp(argv[arg], "--stats") == 0) && (arg < argc - 1) &&
+             ((strcmp(argv[arg + 1], "text") == 0) ||
+              (strcmp(argv[arg + 1], "json") == 0)))
+    {
+      startStats(&stats, strcmp(argv[arg + 1], "json") == 0);
+      session.stats_ = &stats;
+      arg += 2;
+    }
+    else if ((strcmp(argv[arg], "--convert") == 0) && (arg < argc - 2))
+    {
+      return convertDealFiles(argc - arg - 1, &argv[arg + 1]);
+    }
+    else if (strcmp(argv[arg], "--bench") == 0)
+    {
+      return mainBenchFunction(argc - arg - 1, &argv[arg + 1]);
+    }
+    else if ((strcmp(argv[arg], "--selftest") == 0) && (arg == argc - 1))
+    {
+      return mainSelftestFunction();
+    }
+    else if ((strcmp(argv[arg], "--serve") == 0) && (arg == argc - 2))
+    {
+      return mainServerFunction(argv[arg + 1]);
+    }
+    else if ((strcmp(argv[arg], "--sweep") == 0) && (arg < argc - 1) &&
+             (session.threads_ >= 1) && (session.threads_ <= MAX_THREADS) &&
+             (session.stats_ == NULL))
+    {
+      return mainSweepFunction(argc - arg - 1, &argv[arg + 1],
+                               session.threads_);
+    }
+    else if ((strcmp(argv[arg], "--generate") == 0) && (arg < argc - 2))
+    {
+      return generateDealFiles(argc - arg - 1, &argv[arg + 1]);
+    }
+    else if ((strcmp(argv[arg], "--deal") == 0) && (arg < argc - 1) &&
+             (readDealNumber(argv[arg + 1], &deal_number) == 0))
+    {
+      generated = 1;
+      arg += 2;
+    }
+    else if (strcmp(argv[arg], "--solve") == 0)
+    {
+      solve_only = 1;
+      arg++;
+    }
+    else if ((strcmp(argv[arg], "--perft") == 0) && (arg < argc - 1) &&
+             (readDealNumber(argv[arg + 1], &perft_depth) == 0) &&
+             (perft_depth <= MAX_SEARCH_DEPTH))
+    {
+      perft = 1;
+      arg += 2;
+    }
+    else if (strcmp(argv[arg], "--split") == 0)
+    {
+      split = 1;
+      arg++;
+    }
+    else if ((strcmp(argv[arg], "--threads") == 0) && (arg < argc - 1))
+    {
+      session.threads_ = atoi(argv[arg + 1]);
+      arg += 2;
+    }
+    else if ((strcmp(argv[arg], "--build-tablebase") == 0) &&
+             (arg < argc - 1) && (arg >= argc - 3))
+    {
+      if ((arg == argc - 3) &&
+          ((readDealNumber(argv[arg + 2], &tablebase_cards) != 0) ||
+           (tablebase_cards > TABLEBASE_MAX_CARDS)))
+      {
+        break;
+      }
+      return buildTablebase(argv[arg + 1], (int)tablebase_cards);
+    }
+    else if ((strcmp(argv[arg], "--cache") == 0) && (arg < argc - 1) &&
+             (deal_cache == NULL))
+    {
+      err_var = openDealCache(argv[arg + 1], cache);
+      if (err_var != 0)
+      {
+        if (err_var == 3)
+        {
+          printf("[ERR] Invalid file!\n");
+        }
+        return err_var;
+      }
+      deal_cache = cache;
+      arg += 2;
+    }
+    else if ((strcmp(argv[arg], "--tablebase") == 0) && (arg < argc - 1) &&
+             (tablebase == NULL))
+    {
+      if (openTablebase(argv[arg + 1], endgames) != 0)
+      {
+        printf("[ERR] Invalid file!\n");
+        return 3;
+      }
+      tablebase = endgames;
+      arg += 2;
+    }
+    else
+    {
+      break;
+    }
+  }
+  if ((arg != argc - 1 + generated) || (session.threads_ < 1) ||
+      (session.threads_ > MAX_THREADS) ||
+      ((session.stats_ != NULL) && ((solve_only == 1) || (perft == 1))))
+  {
+    printf("[ERR] Usage: %s [--threads <n>] [--solve] [file-name] | "
+           "--batch [file-name]... | --convert [deal-file] [file-name]... | "
+           "[--threads <n>] [--solve] --deal <number> | "
+           "--generate <number> <count> [deal-file] | --bench [deals] | "
+           "--stats text|json ... | --serve <socket-path> | "
+           "[--threads <n>] --sweep [file-name]... | "
+           "--perft <depth> [--split] [file-name] | --selftest | "
+           "--build-tablebase <file> [cards] | --tablebase <file> ... | "
+           "--cache <file> ...\n",
+           argv[0]);
+    return 1;
+  }
+  DealFile deals;
+  int binary = (generated == 0) && (openDealFile(argv[arg], &deals) == 0);
+  if ((binary == 1) && (solve_only == 1))
+  {
+    err_var = solveDealFile(&deals, argv[arg], session.threads_);
+    closeDealFile(&deals);
+    return err_var;
+  }
+  if ((solve_only == 1) && (binary == 0) && (generated == 0))
+  {
+    return solveDealStream(argv[arg], session.threads_);
+  }
+  FILE *config_file = NULL;
+  Game *game = newGame();
+  if (game == NULL)
+  {
+    if (binary == 1)
+    {
+      closeDealFile(&deals);
+    }
+    printf("[ERR] Out of memory\n");
+    return 2;
+  }
+  if (generated == 1)
+  {
+    generateDeal(deal_number, game->card_instance_);
+    err_var = 0;
+  }
+  else if (binary == 1)
+  {
+    err_var = (deals.count_ == 0) ? 3 :
+              loadDeal(&deals, 0, game->card_instance_);
+    closeDealFile(&deals);
+  }
+  else
+  {
+    config_file = fopen(argv[arg], "r");
+    err_var = entireInputFromFile(config_file, game->card_instance_);
+  }
+  if (err_var == 3)
+  {
+    printf("[ERR] Invalid file!\n");
+    freeGame(game);
+    return 3;
+  }
+  else if (err_var == 2)
+  {
+    freeGame(game);
+    return 2;
+  }
+  startGame(game);
+  if (solve_only == 1)
+  {
+    err_var = solveFromPosition(&game->board_, game->card_instance_,
+                                session.threads_, NULL);
+    freeGame(game);
+    return (err_var == 2) ? 2 : 0;
+  }
+  if (perft == 1)
+  {
+    err_var = mainPerftFunction(game, (int)perft_depth, split);
+    freeGame(game);
+    return err_var;
+  }
+  mainPrintFunction(game->board_.deck_);
+  if (startHintEngine(&hint, game) == 0)
+  {
+    session.hint_ = &hint;
+  }
+  while (1)
+  {
+    err_var = mainGameFunction(game, &session);
+    resetArena(&session.scratch_);
+    if (err_var == 2)
+    {
+      if (session.hint_ != NULL)
+      {
+        stopHintEngine(session.hint_);
+      }
+      freeArena(&session.scratch_);
+      freeGame(game);
+      return 2;
+    }
+    else if (err_var == 0)
+      break;
+    else
+      continue;
+  }
+  if (session.stats_ != NULL)
+  {
+    printStats(session.stats_, stderr);
+  }
+  if (session.hint_ != NULL)
+  {
+    stopHintEngine(session.hint_);
+  }
+  freeArena(&session.scratch_);
+  freeGame(game);
+  return 0;
+}
+#endif
+
+
+
+
+
+
+
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Check if game is over. Checks if user input is a valid command.
+/// If user input is a valid command it changes necessary pointers and
+/// prints a new board. With stats the parsing, checking, moving and
+/// printing of every command are timed and invalid moves are counted by
+/// the rule they broke.
+///
+/// @param game the game
+/// @param session where commands are read from and whether anything is
+/// printed
+///
+/// @return 0 program is over
+/// @return 1 if move command was successful
+/// @return 2 if out of memory
+//
+int mainGameFunction(Game* game, Session* session)
+{
+  if (checkForWin(&game->board_) == 1)
+  {
+    return 0;
+  }
+  int err_var;
+  Stats *stats = session->stats_;
+  long long start;
+  int move_var = 0;
+  Rollout *rollout;
+  if (readUserInput(session) == 1)
+  {
+    start = startPhase(stats);
+    move_var = parseUserInput(session->line_);
+    endPhase(stats, STATS_PARSE, start);
+  }
+  if (move_var == -2)
+  {
+    game->invalid_++;
+    if (stats != NULL)
+    {
+      stats->invalid_commands_++;
+    }
+    if (session->quiet_ == 0)
+    {
+      printf("[INFO] Invalid command!\n");
+    }
+    return 1;
+  }
+  else if (move_var == -1)
+  {
+    if (session->quiet_ == 0)
+    {
+      fputs(HELP_TEXT, stdout);
+    }
+    return 1;
+  }
+  else if (move_var == -3)
+  {
+    if (session->quiet_ == 1)
+    {
+      return 1;
+    }
+    return solveFromPosition(&game->board_, game->card_instance_,
+                             session->threads_, &session->scratch_);
+  }
+  else if (move_var == -7)
+  {
+    if (session->quiet_ == 1)
+    {
+      return 1;
+    }
+    if (session->hint_ == NULL)
+    {
+      printf("[INFO] Hint is not available!\n");
+      return 1;
+    }
+    printHint(session->hint_);
+    return 1;
+  }
+  else if (move_var == -8)
+  {
+    if (session->quiet_ == 1)
+    {
+      return 1;
+    }
+    rollout = (Rollout*)allocateArena(&session->scratch_, sizeof(Rollout));
+    if (rollout == NULL)
+    {
+      printf("[ERR] Out of memory\n");
+      return 2;
+    }
+    rankMoves(&game->board_, game->card_instance_, rollout);
+    printMoveRanking(rollout);
+    return 1;
+  }
+  else if ((move_var == -5) || (move_var == -6))
+  {
+    start = startPhase(stats);
+    err_var = (move_var == -5) ? undoGame(game) : redoGame(game);
+    endPhase(stats, STATS_APPLY, start);
+    if (err_var == -2)
+    {
+      game->invalid_++;
+      if (stats != NULL)
+      {
+        stats->nothing_to_undo_++;
+      }
+      if (session->quiet_ == 0)
+      {
+        printf("[INFO] Nothing to %s!\n", (move_var == -5) ? "undo" : "redo");
+      }
+    }
+    else if (session->quiet_ == 0)
+    {
+      start = startPhase(stats);
+      err_var = mainPrintFunction(game->board_.deck_);
+      endPhase(stats, STATS_RENDER, start);
+      if (session->hint_ != NULL)
+      {
+        updateHint(session->hint_, game, 0);
+      }
+      return err_var;
+    }
+    return 1;
+  }
+  else if (move_var == 0)
+  {
+    return  0;
+  }
+  else
+  {
+    start = startPhase(stats);
+    err_var = checkGameMove(game, move_var);
+    endPhase(stats, STATS_VALIDATE, start);
+    if (err_var != 0)
+    {
+      game->invalid_++;
+      if (stats != NULL)
+      {
+        stats->rejected_[MOVE_STOCK_COVERED - err_var]++;
+      }
+      if (err_var == MOVE_SAME_DECK)
+      {
+        return -2;
+      }
+      if (session->quiet_ == 0)
+      {
+        printf("[INFO] Invalid move command!\n");
+      }
+    }
+    else
+    {
+      start = startPhase(stats);
+      err_var = playGameMove(game, move_var);
+      endPhase(stats, STATS_APPLY, start);
+      if (err_var == 2)
+      {
+        return 2;
+      }
+      if (stats != NULL)
+      {
+        stats->valid_moves_++;
+      }
+      if (session->quiet_ == 0)
+      {
+        start = startPhase(stats);
+        err_var = mainPrintFunction(game->board_.deck_);
+        endPhase(stats, STATS_RENDER, start);
+        if (session->hint_ != NULL)
+        {
+          updateHint(session->hint_, game, move_var);
+        }
+        return err_var;
+      }
+    }
+  }
+  return 1;
+}
+
+//-----------------------------------------------------------------------------
+///
+/// Checks if all cards are on the deposit decks.
+///
+/// @param board the decks of the game
+///
+/// @return 1 if the game is won
+/// @return 0 if there are cards left on decks 0 to 4
+//
+int checkForWin(Board* board)
+{
+  if ((board->deck_[0] == NULL) && (board->deck_[1] == NULL) &&
+      (board->deck_[2] == NULL) && (board->deck_[3] == NULL) &&
+      (board->deck_[4] == NULL))
+  {
+    return 1;
+  }
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Allocates a game. It has no cards until initGame or initGameFromDeal.
+///
+/// @return the game, freeGame frees it
+/// @return NULL if out of memory
+//
+Game* newGame(void)
+{
+  Game *game = (Game*)malloc(sizeof(Game));
+  if (game == NULL)
+  {
+    return NULL;
+  }
+  memset(game, 0, sizeof(Game));
+  return game;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Frees a game made by newGame.
+///
+/// @param game the game or NULL
+//
+void freeGame(Game* game)
+{
+  if (game != NULL)
+  {
+    freeArena(&game->arena_);
+    free(game);
+  }
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Starts a game from the cards in the text, in the format of a deal file.
+/// Nothing is allocated, the same game can be started again and again.
+///
+/// @param game the game
+/// @param text the deal, it does not need to end with 0
+/// @param length number of characters in text
+///
+/// @return 0 if the game was started
+/// @return 3 if the deal is invalid
+//
+int initGame(Game* game, const char* text, size_t length)
+{
+  if (readDealText(text, length, game->card_instance_) != 0)
+  {
+    return 3;
+  }
+  startGame(game);
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Starts a game from a binary deal, DEAL_SIZE card numbers.
+///
+/// @param game the game
+/// @param deal the card numbers
+///
+/// @return 0 if the game was started
+/// @return 3 if the deal is invalid
+//
+int initGameFromDeal(Game* game, const unsigned char* deal)
+{
+  if (decodeDeal(deal, game->card_instance_) != 0)
+  {
+    return 3;
+  }
+  startGame(game);
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Deals the cards of a game and forgets all moves made before.
+///
+/// @param game the game, its cards are set
+//
+void startGame(Game* game)
+{
+  setFirstPointers(&game->board_, game->card_instance_);
+  resetArena(&game->arena_);
+  game->journal_.entries_ = NULL;
+  game->journal_.length_ = 0;
+  game->journal_.position_ = 0;
+  game->journal_.capacity_ = 0;
+  game->moves_ = 0;
+  game->invalid_ = 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Makes a move if it is valid and remembers it for undo. An invalid move
+/// is counted and the board is not changed.
+///
+/// @param game the game
+/// @param move_var the number containing description of the wanted card
+///
+/// @return 0 if the move was made
+/// @return 1 if the move was made and won the game
+/// @return 2 if out of memory
+/// @return the MOVE_ code of the broken rule if the move is invalid
+//
+int applyMove(Game* game, int move_var)
+{
+  int err_var = checkGameMove(game, move_var);
+  if (err_var != 0)
+  {
+    game->invalid_++;
+    return err_var;
+  }
+  err_var = playGameMove(game, move_var);
+  if (err_var == 2)
+  {
+    return 2;
+  }
+  return checkForWin(&game->board_);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Checks a move without making it. A move_var that names no card or deck
+/// is reported first, as the library takes any number, then moving a card
+/// to its own deck, whatever else is wrong with the move.
+///
+/// @param game the game
+/// @param move_var the number containing description of the wanted card
+///
+/// @return 0 if the move is valid
+/// @return the MOVE_ code of the broken rule if it is invalid
+//
+int checkGameMove(Game* game, int move_var)
+{
+  Card *wanted_card;
+  int current_deck;
+  if ((move_var < 0) || (move_var % 100 < 1) || (move_var % 100 > 26) ||
+      (move_var / 100 > 6))
+  {
+    return MOVE_OUT_OF_RANGE;
+  }
+  wanted_card = findCardFromMoveVar(move_var, &game->board_);
+  current_deck = travelToTheTop(wanted_card);
+  if (move_var / 100 == current_deck)
+  {
+    return MOVE_SAME_DECK;
+  }
+  return checkMove(&game->board_, wanted_card, current_deck, move_var / 100);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Makes a move checked by checkGameMove and remembers it for undo. The
+/// move goes into the journal first, so without memory for it the board
+/// is not changed.
+///
+/// @param game the game
+/// @param move_var the number containing description of the wanted card
+///
+/// @return 0 if the move was made
+/// @return 2 if out of memory
+//
+int playGameMove(Game* game, int move_var)
+{
+  Card *wanted_card = findCardFromMoveVar(move_var, &game->board_);
+  int current_deck = wanted_card->deck_;
+  if (recordMove(&game->journal_, &game->arena_, move_var,
+                 current_deck) == 2)
+  {
+    return 2;
+  }
+  moveCards(&game->board_, wanted_card, current_deck, move_var / 100);
+  game->moves_++;
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Takes back the last move of a game.
+///
+/// @param game the game
+///
+/// @return 0 if a move was taken back
+/// @return -2 if there is nothing to undo
+//
+int undoGame(Game* game)
+{
+  return undoMove(&game->board_, &game->journal_);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Makes the last undone move of a game again.
+///
+/// @param game the game
+///
+/// @return 0 if a move was made again
+/// @return -2 if there is nothing to redo
+//
+int redoGame(Game* game)
+{
+  return redoMove(&game->board_, &game->journal_);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Lists every legal move of a game, see generateMoves.
+///
+/// @param game the game
+/// @param moves room for MAX_MOVES move_vars
+///
+/// @return number of moves listed
+//
+int listMoves(Game* game, int* moves)
+{
+  return generateMoves(&game->board_, moves);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Gives the 64 bit hash of the position of a game. Equal positions have
+/// equal hashes, also in different games and runs, see Board.
+///
+/// @param game the game
+///
+/// @return the hash
+//
+unsigned long long hashGame(Game* game)
+{
+  return game->board_.hash_;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Checks if a game is won.
+///
+/// @param game the game
+///
+/// @return 1 if all cards are on the deposit decks
+/// @return 0 if not
+//
+int isGameWon(Game* game)
+{
+  return checkForWin(&game->board_);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Renders the board of a game the way mainPrintFunction prints it.
+///
+/// @param game the game
+/// @param frame buffer of FRAME_SIZE characters, it is not 0 terminated
+///
+/// @return number of characters written
+//
+int renderGame(Game* game, char* frame)
+{
+  return renderBoard(game->board_.deck_, frame);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Plays all deal files without printing the board. A directory stands for
+/// all deal files in it, in alphabetical order. One line is printed per
+/// deal, see batchGameFunction.
+///
+/// @param count number of files and directories
+/// @param paths the files and directories
+/// @param stats the stats of all games, printed in the end, or NULL
+///
+/// @return 0 if all deals were played
+/// @return 2 if out of memory
+//
+int mainBatchFunction(int count, char** paths, Stats* stats)
+{
+  int i;
+  int j;
+  int entries;
+  int err_var = 0;
+  char *deal_name;
+  struct dirent **names;
+  Game *game = newGame();
+  if (game == NULL)
+  {
+    printf("[ERR] Out of memory\n");
+    return 2;
+  }
+  for (i = 0; (i < count) && (err_var != 2); i++)
+  {
+    entries = scandir(paths[i], &names, selectDealFile, alphasort);
+    if (entries < 0)
+    {
+      err_var = batchGameFunction(paths[i], game, stats);
+      continue;
+    }
+    for (j = 0; j < entries; j++)
+    {
+      deal_name = (char*)malloc(strlen(paths[i]) +
+                                strlen(names[j]->d_name) + 2);
+      if (deal_name == NULL)
+      {
+        printf("[ERR] Out of memory\n");
+        err_var = 2;
+      }
+      else if (err_var != 2)
+      {
+        sprintf(deal_name, "%s/%s", paths[i], names[j]->d_name);
+        err_var = batchGameFunction(deal_name, game, stats);
+      }
+      free(deal_name);
+      free(names[j]);
+    }
+    free(names);
+  }
+  if ((stats != NULL) && (err_var != 2))
+  {
+    printStats(stats, stderr);
+  }
+  freeGame(game);
+  return err_var;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Plays the deals of a deal file with the commands from the file with the
+/// same name and ".cmd" appended, the same way mainGameFunction does but
+/// without printing. If there is no such file no command is played. Prints
+/// "<file-name> won|lost moves=<n> invalid=<n>", or
+/// "<file-name> invalid-file" if the deal can not be read. A file with
+/// more deals is read as a DealStream, the lines then start with
+/// "<file-name>:<n>" and an invalid deal is "invalid-deal". The commands
+/// of the deals follow each other in the script, each ended by a line
+/// starting with '#'.
+///
+/// @param deal_name the name of the deal file, "-" is stdin
+/// @param game the game the deals are played in
+/// @param stats where the commands are counted, or NULL
+///
+/// @return 0 if the deals were played
+/// @return 2 if out of memory
+//
+int batchGameFunction(char* deal_name, Game* game, Stats* stats)
+{
+  int err_var;
+  int numbered;
+  char *script_name;
+  DealStream *stream;
+  Session session = {.input_ = NULL, .quiet_ = 1, .threads_ = 1};
+  session.stats_ = stats;
+  session.sections_ = 1;
+  script_name = (char*)malloc(strlen(deal_name) + 5);
+  stream = (DealStream*)malloc(sizeof(DealStream));
+  if ((script_name == NULL) || (stream == NULL))
+  {
+    free(script_name);
+    free(stream);
+    printf("[ERR] Out of memory\n");
+    return 2;
+  }
+  if (openDealStream(stream, deal_name) == 3)
+  {
+    printf("%s invalid-file\n", deal_name);
+    free(script_name);
+    free(stream);
+    return 0;
+  }
+  sprintf(script_name, "%s.cmd", deal_name);
+  session.input_ = fopen(script_name, "r");
+  free(script_name);
+  err_var = readStreamDeal(stream, game->card_instance_);
+  numbered = (stream->next_result_ != 1);
+  if ((err_var == 1) && (numbered == 0))
+  {
+    err_var = 3;
+  }
+  while ((err_var == 0) || (err_var == 3))
+  {
+    session.section_end_ = 0;
+    if (err_var == 0)
+    {
+      startGame(game);
+      while (session.input_ != NULL)
+      {
+        err_var = mainGameFunction(game, &session);
+        resetArena(&session.scratch_);
+        if ((err_var == 0) || (err_var == 2))
+        {
+          break;
+        }
+      }
+      if (err_var == 2)
+      {
+        break;
+      }
+    }
+    if (numbered == 1)
+    {
+      printf("%s:%ld ", deal_name, stream->deals_ - 1);
+    }
+    else
+    {
+      printf("%s ", deal_name);
+    }
+    if (err_var == 3)
+    {
+      printf("invalid-%s\n", (numbered == 1) ? "deal" : "file");
+    }
+    else
+    {
+      printf("%s moves=%d invalid=%d\n",
+             (isGameWon(game) == 1) ? "won" : "lost", game->moves_,
+             game->invalid_);
+    }
+    if (session.input_ != NULL)
+    {
+      skipScriptSection(&session);
+    }
+    err_var = readStreamDeal(stream, game->card_instance_);
+  }
+  if (session.input_ != NULL)
+  {
+    fclose(session.input_);
+  }
+  freeArena(&session.scratch_);
+  closeDealStream(stream);
+  free(stream);
+  return (err_var == 2) ? 2 : 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Filter for scandir, skips hidden files and command scripts.
+///
+/// @param entry the directory entry
+///
+/// @return 1 if the entry is a deal file
+/// @return 0 otherwise
+//
+int selectDealFile(const struct dirent* entry)
+{
+  size_t length = strlen(entry->d_name);
+  if (entry->d_name[0] == '.')
+  {
+    return 0;
+  }
+  if ((length > 4) && (strcmp(&entry->d_name[length - 4], ".cmd") == 0))
+  {
+    return 0;
+  }
+  return 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Prints a table with first two rows same always, but under these two rows
+/// cards are changing and printing every time a successful command was ran.
+/// The whole table is rendered into one buffer and written at once.
+///
+/// @param deck array of pointers to the first card in every deck
+///
+/// @return 1 if printing was successful
+//
+int mainPrintFunction(Card** deck)
+{
+  char frame[FRAME_SIZE];
+  int length = renderBoard(deck, frame);
+  fwrite(frame, 1, length, stdout);
+  return 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Renders the table into a buffer. There are 16 rows, in every row the
+/// next card of every deck is written. Deck 0 shows "X  " for all cards but
+/// the bottom one, empty slots are "   ".
+///
+/// @param deck array of pointers to the first card in every deck
+/// @param frame buffer of FRAME_SIZE characters, it is not 0 terminated
+///
+/// @return number of characters written
+//
+int renderBoard(Card** deck, char* frame)
+{
+  static const char header[] = "0   | 1   | 2   | 3   | 4   | DEP | DEP\n"
+                               "---------------------------------------\n";
+  static const char card_glyphs[26][4] = {
+    "RA ", "R2 ", "R3 ", "R4 ", "R5 ", "R6 ", "R7 ", "R8 ", "R9 ", "R10",
+    "RJ ", "RQ ", "RK ", "BA ", "B2 ", "B3 ", "B4 ", "B5 ", "B6 ", "B7 ",
+    "B8 ", "B9 ", "B10", "BJ ", "BQ ", "BK "};
+  int i;
+  int j;
+  const char *glyph;
+  char *output = frame;
+  Card *column[7];
+  memcpy(output, header, sizeof(header) - 1);
+  output += sizeof(header) - 1;
+  for (j = 0; j < 7; j++)
+  {
+    column[j] = deck[j];
+  }
+  for (i = 0; i < 16; i++)
+  {
+    for (j = 0; j < 7; j++)
+    {
+      if (j > 0)
+      {
+        memcpy(output, " | ", 3);
+        output += 3;
+      }
+      if (column[j] == NULL)
+      {
+        glyph = "   ";
+      }
+      else if ((j == 0) && (column[j]->next_ != NULL))
+      {
+        glyph = "X  ";
+      }
+      else
+      {
+        glyph = card_glyphs[getCardNumber(column[j])];
+      }
+      memcpy(output, glyph, 3);
+      output += 3;
+      if (column[j] != NULL)
+      {
+        column[j] = column[j]->next_;
+      }
+    }
+    *output++ = '\n';
+  }
+  return (int)(output - frame);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Returns the number of a card, value - 1 for red and value + 12 for black.
+///
+/// @param card the card
+///
+/// @return the number of the card
+//
+int getCardNumber(Card* card)
+{
+  return card->value_ - 1 + ((card->color_ == 'B') ? 13 : 0);
+}
+
+
+
+
+
+
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Returns the number of the deck that the wanted card is in.
+///
+/// @param wanted_card pointer to the wanted card
+///
+/// @return number of the deck the card is in
+//
+int travelToTheTop(Card *wanted_card)
+{
+  return wanted_card->deck_;
+}
+
+
+
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Makes a move if the rules permit it. Nothing is printed, so the function
+/// can be used by the solver as well.
+///
+/// @param board the decks of the game
+/// @param wanted_card pointer to the wanted card
+/// @param current_deck the deck that the card is in
+/// @param desired_deck the deck that we want to move the card to
+///
+/// @return 0 if move is permitted and was made
+/// @return the MOVE_ code of the broken rule if the move is invalid
+//
+int makeMove(Board* board, Card* wanted_card, int current_deck,
+             int desired_deck)
+{
+  int err_var = checkMove(board, wanted_card, current_deck, desired_deck);
+  if (err_var != 0)
+  {
+    return err_var;
+  }
+  moveCards(board, wanted_card, current_deck, desired_deck);
+  return 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Applies the rules that depend only on the source and destination deck,
+/// then hands the move over to the deposit or tableau rules. The board is
+/// not changed.
+///
+/// @param board the decks of the game
+/// @param wanted_card pointer to the wanted card
+/// @param current_deck the deck that the card is in
+/// @param desired_deck the deck that we want to move the card to
+///
+/// @return 0 if move is permitted
+/// @return the MOVE_ code of the broken rule if the move is invalid
+//
+int checkMove(Board* board, Card* wanted_card, int current_deck,
+              int desired_deck)
+{
+  if ((current_deck == 0) && (wanted_card->next_ != NULL))
+  {
+    return MOVE_STOCK_COVERED;
+  }
+  else if ((current_deck == 5) || (current_deck == 6))
+  {
+    return MOVE_FROM_DEPOSIT;
+  }
+  else if (desired_deck == 0)
+  {
+    return MOVE_TO_STOCK;
+  }
+  else if (desired_deck == current_deck)
+  {
+    return MOVE_SAME_DECK;
+  }
+  else if ((desired_deck == 5) || (desired_deck == 6))
+  {
+    return checkMoveForDeposit(board, wanted_card, desired_deck);
+  }
+  else
+  {
+    return checkForValidMove(board, wanted_card, desired_deck);
+  }
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Lists every legal move as a move_var, without changing the board. Moves
+/// to the deposit decks come first, then tableau moves, each ordered by card
+/// number and deck.
+///
+/// @param board the decks of the game
+/// @param moves room for MAX_MOVES move_vars
+///
+/// @return number of moves listed
+//
+int generateMoves(Board* board, int* moves)
+{
+  int i;
+  int pass;
+  int desired_deck;
+  int count = 0;
+  Card *wanted_card;
+  for (pass = 0; pass < 2; pass++)
+  {
+    for (i = 0; i < 26; i++)
+    {
+      wanted_card = board->index_[i];
+      if ((wanted_card->deck_ > 4) ||
+          ((wanted_card->deck_ == 0) && (wanted_card->next_ != NULL)))
+      {
+        continue;
+      }
+      for (desired_deck = (pass == 0) ? 5 : 1;
+           desired_deck < ((pass == 0) ? 7 : 5); desired_deck++)
+      {
+        if (checkMove(board, wanted_card, wanted_card->deck_,
+                      desired_deck) == 0)
+        {
+          moves[count++] = desired_deck * 100 + i + 1;
+        }
+      }
+    }
+  }
+  return count;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Takes back the last move made with moveCards. The moved cards are at the
+/// bottom of their deck and the bottom of the deck they came from is still
+/// the card they were moved away from, so moving them back puts every
+/// pointer where it was.
+///
+/// @param board the decks of the game
+/// @param wanted_card the card that was moved
+/// @param from_deck the deck the card came from
+//
+void unmakeMove(Board* board, Card* wanted_card, int from_deck)
+{
+  moveCards(board, wanted_card, wanted_card->deck_, from_deck);
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Adds a move to the journal. Moves that were undone can not be redone
+/// after this. A full journal is copied to twice the room in the arena.
+///
+/// @param journal the moves of the game
+/// @param arena the arena of the game
+/// @param move_var the move
+/// @param from_deck the deck the card came from
+///
+/// @return 0 if the move was added
+/// @return 2 if out of memory
+//
+int recordMove(Journal* journal, Arena* arena, int move_var, int from_deck)
+{
+  JournalEntry *entries;
+  if (journal->position_ == journal->capacity_)
+  {
+    entries = (JournalEntry*)allocateArena(arena, 2 *
+                                           (journal->capacity_ + 32) *
+                                           sizeof(JournalEntry));
+    if (entries == NULL)
+    {
+      printf("[ERR] Out of memory\n");
+      return 2;
+    }
+    if (journal->length_ > 0)
+    {
+      memcpy(entries, journal->entries_,
+             journal->length_ * sizeof(JournalEntry));
+    }
+    journal->entries_ = entries;
+    journal->capacity_ = 2 * (journal->capacity_ + 32);
+  }
+  journal->entries_[journal->position_].move_var_ = move_var;
+  journal->entries_[journal->position_].from_deck_ = from_deck;
+  journal->position_++;
+  journal->length_ = journal->position_;
+  return 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Takes back the last move of the journal.
+///
+/// @param board the decks of the game
+/// @param journal the moves of the game
+///
+/// @return 0 if a move was taken back
+/// @return -2 if there is no move to take back
+//
+int undoMove(Board* board, Journal* journal)
+{
+  JournalEntry *entry;
+  if (journal->position_ == 0)
+  {
+    return -2;
+  }
+  entry = &journal->entries_[--journal->position_];
+  unmakeMove(board, findCardFromMoveVar(entry->move_var_, board),
+             entry->from_deck_);
+  return 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Makes the last move taken back by undoMove again.
+///
+/// @param board the decks of the game
+/// @param journal the moves of the game
+///
+/// @return 0 if the move was made again
+/// @return -2 if there is no move to make again
+//
+int redoMove(Board* board, Journal* journal)
+{
+  JournalEntry *entry;
+  if (journal->position_ == journal->length_)
+  {
+    return -2;
+  }
+  entry = &journal->entries_[journal->position_++];
+  moveCards(board, findCardFromMoveVar(entry->move_var_, board),
+            entry->from_deck_, entry->move_var_ / 100);
+  return 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Hands out memory from an arena, aligned to ARENA_ALIGNMENT. A new block
+/// of at least ARENA_BLOCK_SIZE bytes is allocated only if no block after
+/// the current one has room left.
+///
+/// @param arena the arena
+/// @param size number of bytes wanted
+///
+/// @return the memory, it is given back by resetArena or freeArena
+/// @return NULL if out of memory
+//
+void* allocateArena(Arena* arena, size_t size)
+{
+  ArenaBlock *block = arena->current_;
+  ArenaBlock *bigger;
+  size_t block_size;
+  size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+  while ((block != NULL) && (block->size_ - block->used_ < size))
+  {
+    block = block->next_;
+  }
+  if (block == NULL)
+  {
+    block_size = (size > ARENA_BLOCK_SIZE) ? size : ARENA_BLOCK_SIZE;
+    bigger = (ArenaBlock*)malloc(sizeof(ArenaBlock) + block_size);
+    if (bigger == NULL)
+    {
+      return NULL;
+    }
+    bigger->size_ = block_size;
+    bigger->used_ = 0;
+    if (arena->current_ == NULL)
+    {
+      bigger->next_ = arena->first_;
+      arena->first_ = bigger;
+    }
+    else
+    {
+      bigger->next_ = arena->current_->next_;
+      arena->current_->next_ = bigger;
+    }
+    block = bigger;
+  }
+  arena->current_ = block;
+  block->used_ += size;
+  return &block->memory_[block->used_ - size];
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Gives back all memory handed out by an arena. The blocks are kept for
+/// the next allocations.
+///
+/// @param arena the arena
+//
+void resetArena(Arena* arena)
+{
+  ArenaBlock *block;
+  for (block = arena->first_; block != NULL; block = block->next_)
+  {
+    block->used_ = 0;
+  }
+  arena->current_ = arena->first_;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Frees all blocks of an arena, it can be used again afterwards.
+///
+/// @param arena the arena
+//
+void freeArena(Arena* arena)
+{
+  ArenaBlock *block;
+  while (arena->first_ != NULL)
+  {
+    block = arena->first_;
+    arena->first_ = block->next_;
+    free(block);
+  }
+  arena->current_ = NULL;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Checks if inputted command is valid for the current game state.
+///
+/// @param board the decks of the game
+/// @param wanted_card pointer to the wanted card
+/// @param desired_deck the deck that we want to move the card to
+///
+/// @return 0 if move is permitted
+/// @return the MOVE_ code of the broken rule if the move is invalid
+//
+int checkForValidMove(Board* board, Card* wanted_card, int desired_deck)
+{
+  Card *ptr_to_btm;
+  ptr_to_btm = travelToTheBottom(board, desired_deck);
+  if (checkCardsBelow(*wanted_card) == -1)
+  {
+    return MOVE_INVALID_RUN;
+  }
+  if (ptr_to_btm == NULL)
+  {
+    if (wanted_card->value_ != 13)
+    {
+      return MOVE_TABLEAU_KING;
+    }
+  }
+  else if (ptr_to_btm->color_ != wanted_card->color_)
+  {
+    if (ptr_to_btm->value_ != wanted_card->value_ + 1)
+    {
+      return MOVE_TABLEAU_SEQUENCE;
+    }
+  }
+  else
+  {
+    return MOVE_TABLEAU_SEQUENCE;
+  }
+  return 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Checks move command for deposit decks because of the special rules
+/// applied to these two decks.
+///
+/// @param board the decks of the game
+/// @param wanted_card pointer to the wanted card
+/// @param desired_deck the deck that we want to move the card to
+///
+/// @return 0 if move is permitted
+/// @return the MOVE_ code of the broken rule if the move is invalid
+//
+int checkMoveForDeposit(Board* board, Card* wanted_card, int desired_deck)
+{
+  Card* ptr_to_btm;
+  ptr_to_btm = travelToTheBottom(board, desired_deck);
+  if (wanted_card->next_ != NULL)
+  {
+    return MOVE_DEPOSIT_COVERED;
+  }
+  else if (ptr_to_btm == NULL)
+  {
+    if (wanted_card->value_ != 1)
+    {
+      return MOVE_DEPOSIT_ACE;
+    }
+  }
+  else
+  {
+    if (wanted_card->color_ == ptr_to_btm->color_)
+    {
+      if (wanted_card->value_ != ptr_to_btm->value_ + 1)
+      {
+        return MOVE_DEPOSIT_SEQUENCE;
+      }
+    }
+    else
+    {
+      return MOVE_DEPOSIT_SEQUENCE;
+    }
+  }
+  return 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Moves the wanted card together with all cards below it to the bottom of
+/// the desired deck. Rules are not checked here. Heads, tails, the
+/// deck_/depth_ of the moved cards and the hash of the position are updated,
+/// which costs one step per moved card.
+///
+/// @param board the decks of the game
+/// @param wanted_card pointer to the wanted card
+/// @param current_deck the deck that the card is in
+/// @param desired_deck the deck that we want to move the card to
+//
+void moveCards(Board* board, Card* wanted_card, int current_deck,
+               int desired_deck)
+{
+  Card *ptr_to_btm = board->tail_[desired_deck];
+  Card *ptr;
+  int number;
+  int depth = (ptr_to_btm == NULL) ? 0 : ptr_to_btm->depth_ + 1;
+  if (wanted_card->prev_ == NULL)
+  {
+    board->deck_[current_deck] = NULL;
+  }
+  else
+  {
+    wanted_card->prev_->next_ = NULL;
+  }
+  if (ptr_to_btm == NULL)
+  {
+    board->deck_[desired_deck] = wanted_card;
+  }
+  else
+  {
+    ptr_to_btm->next_ = wanted_card;
+  }
+  board->tail_[desired_deck] = board->tail_[current_deck];
+  board->tail_[current_deck] = wanted_card->prev_;
+  wanted_card->prev_ = ptr_to_btm;
+  for (ptr = wanted_card; ptr != NULL; ptr = ptr->next_)
+  {
+    number = getCardNumber(ptr);
+    board->hash_ ^= position_keys[number][ptr->deck_][ptr->depth_] ^
+                    position_keys[number][desired_deck][depth];
+    board->deck_hash_[ptr->deck_] ^= depth_keys[number][ptr->depth_];
+    board->deck_hash_[desired_deck] ^= depth_keys[number][depth];
+    ptr->deck_ = desired_deck;
+    ptr->depth_ = depth++;
+  }
+}
+
+
+
+
+
+
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Return the address of the card described by the user input. Three digit
+/// passed to the function, the last two digits are the description of the
+/// card, if bigger than 13, then card is black and value is for 13 less than
+/// the last two digits, otherwise two digits are the value and the color is
+/// red. The last two digits minus one are the number of the card in the
+/// board index.
+///
+/// @param move_var the number containing description of the wanted card
+/// @param board the decks of the game
+///
+/// @return pointer to the wanted card
+//
+Card* findCardFromMoveVar(int move_var, Board* board)
+{
+  return board->index_[(move_var % 100) - 1];
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Returns address of the card at the bottom of a deck.
+///
+/// @param board the decks of the game
+/// @param deck_number the deck we want the bottom card of
+///
+/// @return the card at the bottom
+/// @return NULL if deck is completely empty
+//
+Card* travelToTheBottom(Board* board, int deck_number)
+{
+  return board->tail_[deck_number];
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Checks if the card we want to move can be moved with all the other cards
+/// below it.
+///
+/// @param card_instance pointer to card for which deck we want to check for
+///
+/// @return 0 if moving all cards below is permitted
+/// @return -1 if moving all cards below is not permitted
+//
+int checkCardsBelow(Card card_instance)
+{
+  Card *ptr;
+  for (ptr = &card_instance; ptr->next_ != NULL; ptr = ptr->next_)
+  {
+    if ((ptr->next_->color_ == ptr->color_) ||
+        (ptr->next_->value_ != ptr->value_ - 1))
+    {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// At the beginning of every command prints "esp>" and awaits for the
+/// following command to be executed by the user input. The line is read
+/// into the buffer of the session and split there, nothing is allocated.
+/// Only the first five words are looked at, and the part of a line longer
+/// than LINE_SIZE is skipped.
+///
+/// @param session the stream the command is read from, the line buffer and
+/// whether "esp>" is printed
+///
+/// @return move_var the number containing description of the wanted card
+/// @return 0 if command is exit or EOF
+/// @return -1 if command is help
+/// @return -2 if command is invalid
+/// @return -3 if command is solve
+/// @return -5 if command is undo
+/// @return -6 if command is redo
+/// @return -7 if command is hint
+/// @return -8 if command is rank
+//
+int checkUserInput(Session* session)
+{
+  if (readUserInput(session) == 0)
+  {
+    return 0;
+  }
+  return parseUserInput(session->line_);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Prints "esp>" unless the session is quiet and reads the next line into
+/// the buffer of the session. With sections a line starting with '#' is
+/// the end of the commands.
+///
+/// @param session the stream the command is read from and the line buffer
+///
+/// @return 1 if a line was read
+/// @return 0 on EOF or at the end of the section
+//
+int readUserInput(Session* session)
+{
+  char *read_line = session->line_;
+  size_t length;
+  int c;
+  if (session->quiet_ == 0)
+  {
+    printf("esp> ");
+  }
+  if ((fgets(read_line, LINE_SIZE, session->input_) == NULL) ||
+      (feof(session->input_) != 0))
+  {
+    return 0;
+  }
+  if ((session->sections_ == 1) && (read_line[0] == '#'))
+  {
+    session->section_end_ = 1;
+  }
+  // a line starting with a NUL byte has no length to look at
+  length = strlen(read_line);
+  if ((length > 0) && (read_line[length - 1] != '\n'))
+  {
+    do
+    {
+      c = fgetc(session->input_);
+    } while ((c != '\n') && (c != EOF));
+    if (c == EOF)
+    {
+      return 0;
+    }
+  }
+  return (session->section_end_ == 1) ? 0 : 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Skips the commands left in the section of a deal that is over, up to
+/// and with the next line starting with '#'.
+///
+/// @param session the stream of commands
+//
+void skipScriptSection(Session* session)
+{
+  int c;
+  int line_start = 1;
+  int header = 0;
+  while ((session->section_end_ == 0) &&
+         ((c = fgetc(session->input_)) != EOF))
+  {
+    if ((line_start == 1) && (c == '#'))
+    {
+      header = 1;
+    }
+    line_start = (c == '\n');
+    if ((line_start == 1) && (header == 1))
+    {
+      session->section_end_ = 1;
+    }
+  }
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Splits a command line into words in place and turns it into a command,
+/// see checkUserInput.
+///
+/// @param read_line the line, 0 terminated, it is changed
+///
+/// @return the command as checkUserInput returns it
+//
+int parseUserInput(char* read_line)
+{
+  static const Keyword commands[] = {{"MOVE", 1}, {"HELP", -1}, {"EXIT", 0},
+                                     {"SOLVE", -3}, {"UNDO", -5},
+                                     {"REDO", -6}, {"HINT", -7},
+                                     {"RANK", -8}};
+  static const Keyword colors[] = {{"RED", 0}, {"BLACK", 13}};
+  char *tokens[5] = {NULL, NULL, NULL, NULL, NULL};
+  int count = 0;
+  int i;
+  int command;
+  int color_var;
+  int value;
+  int move_var;
+  for (i = 0; read_line[i] != '\0'; i++)
+  {
+    if ((read_line[i] == ' ') || (read_line[i] == '\n'))
+    {
+      read_line[i] = '\0';
+    }
+    else
+    {
+      read_line[i] = toupper(read_line[i]);
+      if (((i == 0) || (read_line[i - 1] == '\0')) && (count < 5))
+      {
+        tokens[count++] = &read_line[i];
+      }
+    }
+  }
+  command = findKeyword(commands, 8, tokens[0]);
+  if (command != 1)
+  {
+    return ((command != -2) && (tokens[1] == NULL)) ? command : -2;
+  }
+  color_var = findKeyword(colors, 2, tokens[1]);
+  if (color_var == -2)
+  {
+    return -2;
+  }
+  value = checkCardValue(tokens[2]);
+  if (value == -1)
+  {
+    return -2;
+  }
+  value += color_var;
+  if ((tokens[3] == NULL) || (strcmp(tokens[3], "TO") != 0))
+  {
+    return -2;
+  }
+  move_var = checkDeckNumber(tokens[4]);
+  if (move_var == -1)
+  {
+    return -2;
+  }
+  return (move_var * 100) + value;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Looks a word up in a table of keywords.
+///
+/// @param keywords the table
+/// @param count number of keywords in the table
+/// @param tok the word, may be NULL
+///
+/// @return the code of the keyword
+/// @return -2 if the word is not in the table
+//
+int findKeyword(const Keyword* keywords, int count, char* tok)
+{
+  int i;
+  if (tok == NULL)
+  {
+    return -2;
+  }
+  for (i = 0; i < count; i++)
+  {
+    if (strcmp(tok, keywords[i].word_) == 0)
+    {
+      return keywords[i].code_;
+    }
+  }
+  return -2;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Function that checks what deck number the user wants a card moved to, then
+/// returns the number of that deck
+///
+/// @param tok token containing the number we want, represented as a string
+///
+/// @return -1 if token is invalid
+/// @return number of deck that we want to move to
+//
+int checkDeckNumber(char* tok)
+{
+  if ((tok != NULL) && (tok[0] >= '0') && (tok[0] <= '6') &&
+      ((tok[1] == 10) || (tok[1] == 0) || (tok[1] == 13)))
+  {
+    return tok[0] - '0';
+  }
+  return -1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Setting up the decks.
+/// This function is for pointing all the cards to the decks.
+/// The cards are set up as described in Palme.
+///
+/// @param board the decks of the game
+/// @param card_instance pointer to card for which deck we want to check for
+///
+//
+void setFirstPointers(Board* board, Card* card_instance)
+{
+  board->deck_[0] = &card_instance[0];
+  
+  board->deck_[1] = &card_instance[25];
+  card_instance[25].prev_ = NULL;
+  card_instance[25].next_ = NULL;
+  
+  board->deck_[2] = &card_instance[24];
+  card_instance[24].prev_ = NULL;
+  card_instance[24].next_ = &card_instance[21];
+  card_instance[21].prev_ = &card_instance[24];
+  card_instance[21].next_ = NULL;
+  
+  board->deck_[3] = &card_instance[23];
+  card_instance[23].prev_ = NULL;
+  card_instance[23].next_ = &card_instance[20];
+  card_instance[20].prev_ = &card_instance[23];
+  card_instance[20].next_ = &card_instance[18];
+  card_instance[18].prev_ = &card_instance[20];
+  card_instance[18].next_ = NULL;
+  
+  board->deck_[4] = &card_instance[22];
+  card_instance[22].prev_ = NULL;
+  card_instance[22].next_ = &card_instance[19];
+  card_instance[19].prev_ = &card_instance[22];
+  card_instance[19].next_ = &card_instance[17];
+  card_instance[17].prev_ = &card_instance[19];
+  card_instance[17].next_ = &card_instance[16];
+  card_instance[16].prev_ = &card_instance[17];
+  card_instance[16].next_ = NULL;
+  
+  board->deck_[5] = NULL;
+  board->deck_[6] = NULL;
+  
+  int i;
+
+  for (i = 0; i < 16; i++)
+  {
+    card_instance[i].prev_ = &card_instance[i - 1];
+    card_instance[i].next_ = &card_instance[i + 1];
+  }
+  card_instance[15].next_ = NULL;
+  card_instance[0].prev_ = NULL;
+  indexBoard(board, card_instance);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Builds the card index, the tails, deck_/depth_ of every card and the hash
+/// of the position from the heads of the decks and the links between the
+/// cards.
+///
+/// @param board the decks of the game
+/// @param card_instance array of cards in the double-linked list
+//
+void indexBoard(Board* board, Card* card_instance)
+{
+  int i;
+  int depth;
+  Card *ptr;
+  pthread_once(&position_keys_once, initPositionKeys);
+  for (i = 0; i < 26; i++)
+  {
+    board->index_[getCardNumber(&card_instance[i])] = &card_instance[i];
+  }
+  board->hash_ = 0;
+  for (i = 0; i < 7; i++)
+  {
+    board->tail_[i] = NULL;
+    board->deck_hash_[i] = 0;
+    depth = 0;
+    for (ptr = board->deck_[i]; ptr != NULL; ptr = ptr->next_)
+    {
+      ptr->deck_ = i;
+      ptr->depth_ = depth++;
+      board->tail_[i] = ptr;
+      board->hash_ ^= position_keys[getCardNumber(ptr)][i][ptr->depth_];
+      board->deck_hash_[i] ^= depth_keys[getCardNumber(ptr)][ptr->depth_];
+    }
+  }
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Fills position_keys and depth_keys with splitmix64 numbers from a fixed
+/// seed, so a position has the same hash in every run.
+//
+void initPositionKeys(void)
+{
+  unsigned long long state = 0;
+  int card;
+  int deck;
+  int depth;
+  for (card = 0; card < 26; card++)
+  {
+    for (deck = 0; deck < 7; deck++)
+    {
+      for (depth = 0; depth < 26; depth++)
+      {
+        state += 0x9e3779b97f4a7c15ULL;
+        position_keys[card][deck][depth] = mixHash(state);
+      }
+    }
+    for (depth = 0; depth < 26; depth++)
+    {
+      state += 0x9e3779b97f4a7c15ULL;
+      depth_keys[card][depth] = mixHash(state);
+    }
+  }
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// The finalizer of splitmix64, every bit of the result depends on every
+/// bit of the hash. 0 stays 0.
+///
+/// @param hash the number to mix
+///
+/// @return the mixed number
+//
+unsigned long long mixHash(unsigned long long hash)
+{
+  hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+  return hash ^ (hash >> 31);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Hash of the position that is the same for all positions that only differ
+/// in the order of the tableau decks 1 to 4 or of the deposit decks 5 and 6,
+/// as the rules treat those decks alike. The deck hashes are mixed and
+/// added, so the order does not matter but cards can not cancel out across
+/// decks. It fits the keys of encodePosition.
+///
+/// @param board the decks of the game
+///
+/// @return the hash
+//
+unsigned long long canonicalHash(Board* board)
+{
+  unsigned long long tableau = mixHash(board->deck_hash_[1]) +
+                               mixHash(board->deck_hash_[2]) +
+                               mixHash(board->deck_hash_[3]) +
+                               mixHash(board->deck_hash_[4]);
+  unsigned long long deposit = mixHash(board->deck_hash_[5] ^
+                                       0x5851f42d4c957f2dULL) +
+                               mixHash(board->deck_hash_[6] ^
+                                       0x5851f42d4c957f2dULL);
+  return board->deck_hash_[0] ^ tableau ^ mixHash(deposit);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Function is used for checking the file validity and lines validity.
+/// The whole file is read into one buffer and checked by readDealText.
+///
+/// @param config_file is a pointer to the file used with the program
+/// @param card_instance pointer to card for which deck we want to check for
+///
+/// @return 0 if file is valid;
+/// @return 2 if out of memory;
+/// @return 3 if file invalid or not found
+//
+int entireInputFromFile(FILE *config_file, Card *card_instance)
+{
+  if (config_file == NULL)
+  {
+    return 3;
+  }
+  size_t length = 0;
+  size_t capacity = 1024;
+  char *text = (char*)malloc(capacity);
+  char *bigger;
+  int err_var;
+  while (text != NULL)
+  {
+    length += fread(&text[length], 1, capacity - length, config_file);
+    if (length < capacity)
+    {
+      break;
+    }
+    capacity *= 2;
+    bigger = (char*)realloc(text, capacity);
+    if (bigger == NULL)
+    {
+      free(text);
+    }
+    text = bigger;
+  }
+  if (text == NULL)
+  {
+    printf("[ERR] Out of memory\n");
+    return 2;
+  }
+  err_var = readDealText(text, length, card_instance);
+  free(text);
+  return err_var;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Reads the 26 cards of a deal from text. Every line that is not empty
+/// holds one card, as "<color> <value>", the lines after the 26th card are
+/// not looked at. Nothing is allocated and the text is not changed.
+///
+/// @param text the deal, it does not need to end with 0
+/// @param length number of characters in text
+/// @param card_instance array of cards that gets the deal
+///
+/// @return 0 if the deal is valid
+/// @return 3 if there are less than 26 cards, a line is invalid or a card
+/// is there twice
+//
+int readDealText(const char* text, size_t length, Card* card_instance)
+{
+  int count = 0;
+  unsigned long mask = 0;
+  size_t position = 0;
+  size_t line_length;
+  const char *line;
+  const char *end;
+  while (count < 26)
+  {
+    if (position >= length)
+    {
+      return 3;
+    }
+    line = &text[position];
+    end = (const char*)memchr(line, '\n', length - position);
+    line_length = (end == NULL) ? length - position : (size_t)(end - line);
+    position += line_length + 1;
+    if (checkForEmptyLine(line, line_length) == 0)
+    {
+      continue;
+    }
+    if (readDealLine(line, line_length, &card_instance[count]) != 0)
+    {
+      return 3;
+    }
+    if ((mask & (1UL << getCardNumber(&card_instance[count]))) != 0)
+    {
+      return 3;
+    }
+    mask |= 1UL << getCardNumber(&card_instance[count]);
+    count++;
+  }
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Reads one card. The words of the line are separated by spaces, the first
+/// one is the color and the second one the value, a third one may only
+/// consist of white space.
+///
+/// @param line the line without the newline
+/// @param length number of characters in the line
+/// @param card gets color and value
+///
+/// @return 0 if the line is valid
+/// @return -1 if it is not
+//
+int readDealLine(const char* line, size_t length, Card* card)
+{
+  const char *words[3] = {NULL, NULL, NULL};
+  size_t sizes[3] = {0, 0, 0};
+  char word[7];
+  int count = 0;
+  size_t i = 0;
+  while ((count < 3) && (i < length))
+  {
+    if (line[i] == ' ')
+    {
+      i++;
+      continue;
+    }
+    words[count] = &line[i];
+    while ((i < length) && (line[i] != ' '))
+    {
+      i++;
+    }
+    sizes[count] = (size_t)(&line[i] - words[count]);
+    count++;
+  }
+  if ((count < 2) || (sizes[0] > 5) ||
+      ((count == 3) && (checkForEmptyLine(words[2], sizes[2]) == 1)))
+  {
+    return -1;
+  }
+  memcpy(word, words[0], sizes[0]);
+  word[sizes[0]] = '\0';
+  card->color_ = checkCardColor(word);
+  memcpy(word, words[1], (sizes[1] < 3) ? sizes[1] : 3);
+  word[(sizes[1] < 3) ? sizes[1] : 3] = '\0';
+  card->value_ = checkCardValue(word);
+  if ((card->color_ == 'E') || (card->value_ == -1))
+  {
+    return -1;
+  }
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Depending on the user input, this function checks for the card color
+///
+///
+/// @param tok used as a token (string part) in string to check for deck number
+///
+/// @return 'R' for red
+/// @return 'B' for black
+/// @return 'E' for non existing color of the card
+//
+char checkCardColor(char* tok)
+{
+  if (strcmp(tok, "RED") == 0)
+  {
+    return 'R';
+  }
+  else if (strcmp(tok, "BLACK") == 0)
+  {
+    return 'B';
+  }
+  else
+  {
+    return 'E';
+  }
+}
+
+
+//-----------------------------------------------------------------------------
+///
+/// Skips all the empty lines in the file.
+///
+/// @param line pointer to the line in file input
+/// @param length number of characters in the line
+///
+/// @return 1 successful
+/// @return 0 not successful
+//
+int checkForEmptyLine(const char *line, size_t length)
+{
+  size_t i;
+  for (i = 0; i < length; i += 1)
+  {
+    if ((line[i] != ' ') && (line[i] != '\n') && (line[i] != '\0') &&
+        (line[i] != '\t') && (line[i] != '\r') && (line[i] != 13))
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Checks for values of the cards in the deck and returns their values.
+/// The first character is looked up in a table, only 10 needs a second one.
+///
+///
+/// @param tok used as a token (string part) in string to check for deck number
+///
+/// @return -1 if wrong
+/// @return required number as the value of the card
+//
+int checkCardValue(char *tok)
+{
+  static const signed char values[128] = {
+    ['A'] = 1, ['2'] = 2, ['3'] = 3, ['4'] = 4, ['5'] = 5, ['6'] = 6,
+    ['7'] = 7, ['8'] = 8, ['9'] = 9, ['1'] = 10, ['J'] = 11, ['Q'] = 12,
+    ['K'] = 13};
+  int value;
+  if ((tok == NULL) || ((unsigned char)tok[0] >= 128))
+  {
+    return -1;
+  }
+  value = values[(int)tok[0]];
+  if (value == 0)
+  {
+    return -1;
+  }
+  if (value == 10)
+  {
+    if (tok[1] != '0')
+    {
+      return -1;
+    }
+    tok++;
+  }
+  if ((tok[1] == 10) || (tok[1] == 0) ||  (tok[1] == 13) ||
+      (tok[1] == (char)EOF))
+  {
+    return value;
+  }
+  return -1;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Writes deal files as binary deals into one file, the first path. Deal
+/// files that can not be read are reported and skipped.
+///
+/// @param count number of paths
+/// @param paths the binary file followed by the deal files
+///
+/// @return 0 if all deal files were written
+/// @return 2 if out of memory
+/// @return 3 if a deal file was invalid or the binary file can not be
+/// written
+//
+int convertDealFiles(int count, char** paths)
+{
+  int i;
+  int err_var = 0;
+  int read_var;
+  int written = 1;
+  unsigned char deal[DEAL_SIZE];
+  Card card_instance[26];
+  FILE *config_file;
+  FILE *deal_file = fopen(paths[0], "wb");
+  if ((deal_file == NULL) ||
+      (fwrite(DEAL_MAGIC, 1, DEAL_MAGIC_SIZE, deal_file) != DEAL_MAGIC_SIZE))
+  {
+    printf("[ERR] Invalid file!\n");
+    if (deal_file != NULL)
+    {
+      fclose(deal_file);
+    }
+    return 3;
+  }
+  for (i = 1; (i < count) && (err_var != 2) && (written == 1); i++)
+  {
+    config_file = fopen(paths[i], "r");
+    read_var = entireInputFromFile(config_file, card_instance);
+    if (config_file != NULL)
+    {
+      fclose(config_file);
+    }
+    if (read_var == 3)
+    {
+      printf("%s invalid-file\n", paths[i]);
+    }
+    if (read_var != 0)
+    {
+      err_var = read_var;
+      continue;
+    }
+    encodeDeal(card_instance, deal);
+    written = (fwrite(deal, 1, DEAL_SIZE, deal_file) == DEAL_SIZE);
+  }
+  if (((fclose(deal_file) != 0) || (written == 0)) && (err_var != 2))
+  {
+    printf("%s invalid-file\n", paths[0]);
+    err_var = 3;
+  }
+  return err_var;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Maps a binary deal file into memory. The deals are not checked here,
+/// loadDeal does that for every deal it loads.
+///
+/// @param path the name of the file
+/// @param deals gets the mapping, closeDealFile releases it
+///
+/// @return 0 if the file is a binary deal file
+/// @return 3 if it is not or can not be read
+//
+int openDealFile(char* path, DealFile* deals)
+{
+  struct stat info;
+  int file = open(path, O_RDONLY);
+  if (file < 0)
+  {
+    return 3;
+  }
+  if ((fstat(file, &info) != 0) || (info.st_size < DEAL_MAGIC_SIZE) ||
+      ((info.st_size - DEAL_MAGIC_SIZE) % DEAL_SIZE != 0))
+  {
+    close(file);
+    return 3;
+  }
+  deals->size_ = (size_t)info.st_size;
+  deals->data_ = (unsigned char*)mmap(NULL, deals->size_, PROT_READ,
+                                      MAP_PRIVATE, file, 0);
+  close(file);
+  if (deals->data_ == MAP_FAILED)
+  {
+    return 3;
+  }
+  if (memcmp(deals->data_, DEAL_MAGIC, DEAL_MAGIC_SIZE) != 0)
+  {
+    munmap(deals->data_, deals->size_);
+    return 3;
+  }
+  madvise(deals->data_, deals->size_, MADV_SEQUENTIAL);
+  deals->count_ = (deals->size_ - DEAL_MAGIC_SIZE) / DEAL_SIZE;
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Unmaps a file opened by openDealFile.
+///
+/// @param deals the mapped file
+//
+void closeDealFile(DealFile* deals)
+{
+  munmap(deals->data_, deals->size_);
+  deals->data_ = NULL;
+  deals->count_ = 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Sets color and value of the cards from one binary deal. Every card
+/// number sets one bit of a mask, the deal is valid if all 26 bits are set,
+/// which means every card is there exactly once.
+///
+/// @param deals the mapped file
+/// @param number which deal, starting with 0
+/// @param card_instance array of cards that gets the deal
+///
+/// @return 0 if the deal is valid
+/// @return 3 if it is invalid
+//
+int loadDeal(DealFile* deals, size_t number, Card* card_instance)
+{
+  return decodeDeal(deals->data_ + DEAL_MAGIC_SIZE + number * DEAL_SIZE,
+                    card_instance);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Sets color and value of the cards from a binary deal, see loadDeal.
+///
+/// @param deal DEAL_SIZE card numbers
+/// @param card_instance array of cards that gets the deal
+///
+/// @return 0 if the deal is valid
+/// @return 3 if it is invalid
+//
+int decodeDeal(const unsigned char* deal, Card* card_instance)
+{
+  int i;
+  unsigned long mask = 0;
+  for (i = 0; i < DEAL_SIZE; i++)
+  {
+    mask |= 1UL << (deal[i] & 31);
+    setCardNumber(&card_instance[i], deal[i]);
+  }
+  return (mask == DEAL_MASK) ? 0 : 3;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Writes the cards of a deal as binary deal.
+///
+/// @param card_instance array of cards as read by entireInputFromFile
+/// @param deal DEAL_SIZE bytes that get the card numbers
+//
+void encodeDeal(Card* card_instance, unsigned char* deal)
+{
+  int i;
+  for (i = 0; i < DEAL_SIZE; i++)
+  {
+    deal[i] = (unsigned char)getCardNumber(&card_instance[i]);
+  }
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Solves every deal of a binary deal file. One line is printed per deal,
+/// "<file-name>:<n> won moves=<n>", "<file-name>:<n> lost" or
+/// "<file-name>:<n> invalid-deal".
+///
+/// @param deals the mapped file
+/// @param deal_name the name of the file
+/// @param threads number of threads solving each deal
+///
+/// @return 0 if all deals were solved
+/// @return 2 if out of memory
+//
+int solveDealFile(DealFile* deals, char* deal_name, int threads)
+{
+  size_t i;
+  int err_var = 0;
+  Solution solution;
+  Arena arena = {NULL, NULL};
+  Card *card_instance;
+  Board *board;
+  card_instance = (Card*)malloc(26 * sizeof(Card));
+  board = (Board*)malloc(sizeof(Board));
+  if ((card_instance == NULL) || (board == NULL))
+  {
+    free(card_instance);
+    free(board);
+    printf("[ERR] Out of memory\n");
+    return 2;
+  }
+  for (i = 0; (i < deals->count_) && (err_var != 2); i++)
+  {
+    if (loadDeal(deals, i, card_instance) == 3)
+    {
+      printf("%s:%zu invalid-deal\n", deal_name, i);
+      continue;
+    }
+    setFirstPointers(board, card_instance);
+    err_var = solveDeal(board, card_instance, &solution, threads, &arena);
+    if (err_var == 1)
+    {
+      printf("%s:%zu won moves=%d\n", deal_name, i, solution.length_);
+    }
+    else if (err_var == 0)
+    {
+      printf("%s:%zu lost\n", deal_name, i);
+    }
+    freeSolution(&solution);
+    resetArena(&arena);
+  }
+  freeArena(&arena);
+  free(board);
+  free(card_instance);
+  return (err_var == 2) ? 2 : 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Opens a stream of deals and reads its first deal ahead.
+///
+/// @param stream the stream
+/// @param path the file, "-" is stdin
+///
+/// @return 0 if the stream is open
+/// @return 3 if the file can not be opened
+//
+int openDealStream(DealStream* stream, char* path)
+{
+  stream->file_ = (strcmp(path, "-") == 0) ? stdin : fopen(path, "r");
+  if (stream->file_ == NULL)
+  {
+    return 3;
+  }
+  stream->deals_ = 0;
+  stream->next_result_ = readDealLines(stream, stream->next_);
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Closes a stream of deals, stdin is left open.
+///
+/// @param stream the stream
+//
+void closeDealStream(DealStream* stream)
+{
+  if (stream->file_ != stdin)
+  {
+    fclose(stream->file_);
+  }
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Hands out the next deal of a stream and reads the one after it ahead.
+/// Afterwards next_result_ is 1 if that was the last deal.
+///
+/// @param stream the stream
+/// @param card_instance array of cards that gets the deal
+///
+/// @return 0 if the deal is valid
+/// @return 1 if there are no more deals
+/// @return 3 if the deal is invalid
+//
+int readStreamDeal(DealStream* stream, Card* card_instance)
+{
+  int err_var = stream->next_result_;
+  if (err_var == 1)
+  {
+    return 1;
+  }
+  memcpy(card_instance, stream->next_, 26 * sizeof(Card));
+  stream->deals_++;
+  stream->next_result_ = readDealLines(stream, stream->next_);
+  return err_var;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Reads the lines of one deal from a stream. Separators before the deal
+/// are skipped. The deal is the first 26 cards, every line read as by
+/// readDealLine, and they have to be different. As in readDealText empty
+/// lines between them are skipped and the lines after the 26th card are
+/// not looked at, up to the next empty or header line, which ends the
+/// deal. A header line also ends a deal that is not complete, and any
+/// separator ends one with an invalid line.
+///
+/// @param stream the stream
+/// @param card_instance array of cards that gets the deal
+///
+/// @return 0 if the deal is valid
+/// @return 1 if there are no more deals
+/// @return 3 if the deal is invalid
+//
+int readDealLines(DealStream* stream, Card* card_instance)
+{
+  int count = 0;
+  int valid = 1;
+  int cut;
+  int c;
+  size_t length;
+  unsigned long mask = 0;
+  char *line = stream->line_;
+  while (fgets(line, LINE_SIZE, stream->file_) != NULL)
+  {
+    length = strlen(line);
+    cut = 0;
+    if ((length > 0) && (line[length - 1] == '\n'))
+    {
+      length--;
+    }
+    else if (length == LINE_SIZE - 1)
+    {
+      do
+      {
+        c = fgetc(stream->file_);
+      } while ((c != '\n') && (c != EOF));
+      cut = 1;
+    }
+    if ((line[0] == '#') || (checkForEmptyLine(line, length) == 0))
+    {
+      if ((count == 26) || (valid == 0) || ((line[0] == '#') && (count > 0)))
+      {
+        break;
+      }
+      continue;
+    }
+    if ((count == 26) || (valid == 0))
+    {
+      continue;
+    }
+    if ((cut == 1) ||
+        (readDealLine(line, length, &card_instance[count]) != 0) ||
+        ((mask & (1UL << getCardNumber(&card_instance[count]))) != 0))
+    {
+      valid = 0;
+      continue;
+    }
+    mask |= 1UL << getCardNumber(&card_instance[count]);
+    count++;
+  }
+  if ((count == 0) && (valid == 1))
+  {
+    return 1;
+  }
+  return ((valid == 1) && (count == 26)) ? 0 : 3;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Solves the deals of a stream. A stream of one deal is solved as a game
+/// is, with the moves printed, see solveFromPosition. With more deals one
+/// line is printed per deal as solveDealFile does.
+///
+/// @param deal_name the file, "-" is stdin
+/// @param threads number of threads solving each deal
+///
+/// @return 0 if all deals were solved
+/// @return 2 if out of memory
+/// @return 3 if the file can not be read or its only deal is invalid
+//
+int solveDealStream(char* deal_name, int threads)
+{
+  int err_var;
+  Solution solution;
+  Arena arena = {NULL, NULL};
+  DealStream *stream = (DealStream*)malloc(sizeof(DealStream));
+  Card *card_instance = (Card*)malloc(26 * sizeof(Card));
+  Board *board = (Board*)malloc(sizeof(Board));
+  if ((stream == NULL) || (card_instance == NULL) || (board == NULL))
+  {
+    free(stream);
+    free(card_instance);
+    free(board);
+    printf("[ERR] Out of memory\n");
+    return 2;
+  }
+  if (openDealStream(stream, deal_name) == 3)
+  {
+    err_var = 3;
+  }
+  else
+  {
+    err_var = readStreamDeal(stream, card_instance);
+    if (stream->next_result_ == 1)
+    {
+      if (err_var == 0)
+      {
+        setFirstPointers(board, card_instance);
+        err_var = (solveFromPosition(board, card_instance, threads,
+                                     &arena) == 2) ? 2 : 0;
+      }
+      else
+      {
+        err_var = 3;
+      }
+    }
+    else
+    {
+      while (err_var != 1)
+      {
+        if (err_var == 3)
+        {
+          printf("%s:%ld invalid-deal\n", deal_name, stream->deals_ - 1);
+        }
+        else
+        {
+          setFirstPointers(board, card_instance);
+          err_var = solveDeal(board, card_instance, &solution, threads,
+                              &arena);
+          if (err_var == 2)
+          {
+            break;
+          }
+          printf("%s:%ld %s", deal_name, stream->deals_ - 1,
+                 (err_var == 1) ? "won" : "lost\n");
+          if (err_var == 1)
+          {
+            printf(" moves=%d\n", solution.length_);
+          }
+          freeSolution(&solution);
+          resetArena(&arena);
+        }
+        err_var = readStreamDeal(stream, card_instance);
+      }
+      err_var = (err_var == 2) ? 2 : 0;
+    }
+    closeDealStream(stream);
+  }
+  if (err_var == 3)
+  {
+    printf("[ERR] Invalid file!\n");
+  }
+  freeArena(&arena);
+  free(stream);
+  free(card_instance);
+  free(board);
+  return err_var;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Sets color and value of a card from its number, the reverse of
+/// getCardNumber.
+///
+/// @param card the card
+/// @param number the number of the card, 0 to 25
+//
+void setCardNumber(Card* card, int number)
+{
+  card->color_ = (number < 13) ? 'R' : 'B';
+  card->value_ = (number < 13) ? number + 1 : number - 12;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Sets the cards of the deal with the given number. The number is first
+/// scrambled like one step of splitmix64, so neighbouring numbers give
+/// unrelated deals. This is the low 64 bits of a rank below 26!, the bits
+/// above come from a second scramble of it and stay below
+/// DEAL_RANK_HIGH = 26! / 2^64. The rank is unranked into a permutation of
+/// the 26 cards with the Myrvold-Ruskey scheme: at every step the remainder
+/// by the number of cards left picks the card swapped to the end. Unranking
+/// is one to one on all ranks below 26! and the low 64 bits of the rank are
+/// the scrambled number, so different numbers always give different deals.
+///
+/// @param deal_number the number of the deal
+/// @param card_instance array of cards that gets the deal
+//
+void generateDeal(unsigned long long deal_number, Card* card_instance)
+{
+  int i;
+  int j;
+  int swap;
+  unsigned char card;
+  unsigned char order[26];
+  unsigned long long rest;
+  unsigned long long rank[3];
+  unsigned long long mixed = deal_number + 0x9e3779b97f4a7c15ULL;
+  mixed = (mixed ^ (mixed >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  mixed = (mixed ^ (mixed >> 27)) * 0x94d049bb133111ebULL;
+  mixed = mixed ^ (mixed >> 31);
+  rank[0] = (((mixed ^ (mixed >> 32)) * 0xd6e8feb86659fd93ULL) >> 32) %
+            DEAL_RANK_HIGH;
+  rank[1] = mixed >> 32;
+  rank[2] = mixed & 0xffffffffULL;
+  for (i = 0; i < 26; i++)
+  {
+    order[i] = (unsigned char)i;
+  }
+  for (i = 25; i > 0; i--)
+  {
+    rest = 0;
+    for (j = 0; j < 3; j++)
+    {
+      rest = (rest << 32) | rank[j];
+      rank[j] = rest / (unsigned long long)(i + 1);
+      rest = rest % (unsigned long long)(i + 1);
+    }
+    swap = (int)rest;
+    card = order[i];
+    order[i] = order[swap];
+    order[swap] = card;
+  }
+  for (i = 0; i < 26; i++)
+  {
+    setCardNumber(&card_instance[i], order[i]);
+  }
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Reads a deal number, all characters have to be digits.
+///
+/// @param tok the text of the number
+/// @param deal_number gets the number
+///
+/// @return 0 if the number is valid
+/// @return -1 if it is not
+//
+int readDealNumber(char* tok, unsigned long long* deal_number)
+{
+  char *end;
+  if ((tok[0] < '0') || (tok[0] > '9'))
+  {
+    return -1;
+  }
+  errno = 0;
+  *deal_number = strtoull(tok, &end, 10);
+  if ((*end != '\0') || (errno != 0))
+  {
+    return -1;
+  }
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Generates count deals starting with the first number. Without a file
+/// name they are printed in the format entireInputFromFile reads, with an
+/// empty line between two deals, otherwise they are written to the file as
+/// binary deals.
+///
+/// @param count number of arguments
+/// @param paths the first number, the count and maybe the file name
+///
+/// @return 0 if all deals were written
+/// @return 1 if the numbers are invalid
+/// @return 3 if the file can not be written
+//
+int generateDealFiles(int count, char** paths)
+{
+  unsigned long long i;
+  unsigned long long first;
+  unsigned long long deals;
+  unsigned char deal[DEAL_SIZE];
+  Card card_instance[26];
+  FILE *deal_file = NULL;
+  if ((count > 3) || (readDealNumber(paths[0], &first) != 0) ||
+      (readDealNumber(paths[1], &deals) != 0))
+  {
+    printf("[ERR] Usage: --generate <number> <count> [deal-file]\n");
+    return 1;
+  }
+  if (count == 3)
+  {
+    deal_file = fopen(paths[2], "wb");
+    if ((deal_file == NULL) ||
+        (fwrite(DEAL_MAGIC, 1, DEAL_MAGIC_SIZE, deal_file) != DEAL_MAGIC_SIZE))
+    {
+      printf("[ERR] Invalid file!\n");
+      if (deal_file != NULL)
+      {
+        fclose(deal_file);
+      }
+      return 3;
+    }
+  }
+  for (i = 0; i < deals; i++)
+  {
+    generateDeal(first + i, card_instance);
+    if (deal_file == NULL)
+    {
+      if (i > 0)
+      {
+        putchar('\n');
+      }
+      printDeal(stdout, card_instance);
+      continue;
+    }
+    encodeDeal(card_instance, deal);
+    if (fwrite(deal, 1, DEAL_SIZE, deal_file) != DEAL_SIZE)
+    {
+      break;
+    }
+  }
+  if ((deal_file != NULL) && ((fclose(deal_file) != 0) || (i < deals)))
+  {
+    printf("%s invalid-file\n", paths[2]);
+    return 3;
+  }
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Prints the cards of a deal one per line, as "RED A" or "BLACK 10".
+///
+/// @param deal_file where the deal is printed
+/// @param card_instance array of cards of the deal
+//
+void printDeal(FILE* deal_file, Card* card_instance)
+{
+  static const char *value_names[] = {"", "A", "2", "3", "4", "5", "6", "7",
+                                      "8", "9", "10", "J", "Q", "K"};
+  int i;
+  for (i = 0; i < 26; i++)
+  {
+    fprintf(deal_file, "%s %s\n",
+            (card_instance[i].color_ == 'R') ? "RED" : "BLACK",
+            value_names[card_instance[i].value_]);
+  }
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Stores the links of all cards and decks as indices into card_instance.
+///
+/// @param board the decks of the game
+/// @param card_instance array of cards in the double-linked list
+/// @param snapshot where the links are stored
+//
+void saveSnapshot(Board* board, Card* card_instance, Snapshot* snapshot)
+{
+  int i;
+  for (i = 0; i < 26; i++)
+  {
+    snapshot->prev_[i] = (card_instance[i].prev_ == NULL) ? -1 :
+                         (signed char)(card_instance[i].prev_ - card_instance);
+    snapshot->next_[i] = (card_instance[i].next_ == NULL) ? -1 :
+                         (signed char)(card_instance[i].next_ - card_instance);
+  }
+  for (i = 0; i < 7; i++)
+  {
+    snapshot->deck_[i] = (board->deck_[i] == NULL) ? -1 :
+                         (signed char)(board->deck_[i] - card_instance);
+  }
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Puts back the links stored by saveSnapshot.
+///
+/// @param board the decks of the game
+/// @param card_instance array of cards in the double-linked list
+/// @param snapshot the stored links
+//
+void restoreSnapshot(Board* board, Card* card_instance, Snapshot* snapshot)
+{
+  int i;
+  for (i = 0; i < 26; i++)
+  {
+    card_instance[i].prev_ = (snapshot->prev_[i] == -1) ? NULL :
+                             &card_instance[(int)snapshot->prev_[i]];
+    card_instance[i].next_ = (snapshot->next_[i] == -1) ? NULL :
+                             &card_instance[(int)snapshot->next_[i]];
+  }
+  for (i = 0; i < 7; i++)
+  {
+    board->deck_[i] = (snapshot->deck_[i] == -1) ? NULL :
+                      &card_instance[(int)snapshot->deck_[i]];
+  }
+  indexBoard(board, card_instance);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Writes a key which describes the position. Deck 0 only ever loses its
+/// bottom card, so its length is enough, all other decks are written card by
+/// card (index + 1) and closed with a 0. The rules treat the tableau decks
+/// 1 to 4 alike and the deposit decks 5 and 6 as well, so they are written
+/// ordered by their top card, empty decks first, and positions that only
+/// differ in the order of those decks get the same key, see canonicalHash.
+///
+/// @param board the decks of the game
+/// @param card_instance array of cards in the double-linked list
+/// @param key KEY_SIZE bytes where the key is written
+//
+void encodePosition(Board* board, Card* card_instance, unsigned char* key)
+{
+  int i;
+  int j;
+  int length;
+  int order[7] = {0, 1, 2, 3, 4, 5, 6};
+  int top[7];
+  int deck;
+  Card *ptr;
+  memset(key, 0, KEY_SIZE);
+  key[0] = (unsigned char)((board->tail_[0] == NULL) ? 1 :
+                           board->tail_[0]->depth_ + 2);
+  length = 1;
+  for (i = 1; i < 7; i++)
+  {
+    top[i] = (board->deck_[i] == NULL) ? 0 :
+             (int)(board->deck_[i] - card_instance + 1);
+  }
+  for (i = 2; i < 5; i++)
+  {
+    deck = order[i];
+    for (j = i; (j > 1) && (top[order[j - 1]] > top[deck]); j--)
+    {
+      order[j] = order[j - 1];
+    }
+    order[j] = deck;
+  }
+  if (top[5] > top[6])
+  {
+    order[5] = 6;
+    order[6] = 5;
+  }
+  for (i = 1; i < 7; i++)
+  {
+    for (ptr = board->deck_[order[i]]; ptr != NULL; ptr = ptr->next_)
+    {
+      key[length++] = (unsigned char)(ptr - card_instance + 1);
+    }
+    key[length++] = 0;
+  }
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Adds a position to the visited table. The table is doubled once it is
+/// half full, in the arena of the table if it has one.
+///
+/// @param visited the table of searched positions
+/// @param key the key of the position
+/// @param hash the hash of the position, see canonicalHash
+///
+/// @return 0 if the position was added
+/// @return 1 if the position was already in the table
+/// @return 2 if out of memory
+//
+int insertPosition(VisitedTable* visited, unsigned char* key,
+                   unsigned long long hash)
+{
+  size_t i;
+  size_t slot;
+  if (2 * (visited->count_ + 1) > visited->size_)
+  {
+    VisitedTable bigger;
+    bigger.size_ = (visited->size_ == 0) ? VISITED_START_SIZE :
+                   visited->size_ * 2;
+    bigger.count_ = 0;
+    bigger.arena_ = visited->arena_;
+    if (bigger.arena_ != NULL)
+    {
+      bigger.keys_ = (unsigned char*)allocateArena(bigger.arena_,
+                                                   bigger.size_ * KEY_SIZE);
+      bigger.hashes_ = (unsigned long long*)allocateArena(
+                         bigger.arena_,
+                         bigger.size_ * sizeof(unsigned long long));
+      if ((bigger.keys_ == NULL) || (bigger.hashes_ == NULL))
+      {
+        printf("[ERR] Out of memory\n");
+        return 2;
+      }
+      memset(bigger.keys_, 0, bigger.size_ * KEY_SIZE);
+    }
+    else
+    {
+      bigger.keys_ = (unsigned char*)calloc(bigger.size_, KEY_SIZE);
+      bigger.hashes_ = (unsigned long long*)malloc(
+                         bigger.size_ * sizeof(unsigned long long));
+      if ((bigger.keys_ == NULL) || (bigger.hashes_ == NULL))
+      {
+        free(bigger.keys_);
+        free(bigger.hashes_);
+        printf("[ERR] Out of memory\n");
+        return 2;
+      }
+    }
+    for (i = 0; i < visited->size_; i++)
+    {
+      if (visited->keys_[i * KEY_SIZE] != 0)
+      {
+        insertPosition(&bigger, &visited->keys_[i * KEY_SIZE],
+                       visited->hashes_[i]);
+      }
+    }
+    if (visited->arena_ == NULL)
+    {
+      free(visited->keys_);
+      free(visited->hashes_);
+    }
+    *visited = bigger;
+  }
+  slot = (size_t)(hash & (visited->size_ - 1));
+  while (visited->keys_[slot * KEY_SIZE] != 0)
+  {
+    if ((visited->hashes_[slot] == hash) &&
+        (memcmp(&visited->keys_[slot * KEY_SIZE], key, KEY_SIZE) == 0))
+    {
+      return 1;
+    }
+    slot = (slot + 1) & (visited->size_ - 1);
+  }
+  memcpy(&visited->keys_[slot * KEY_SIZE], key, KEY_SIZE);
+  visited->hashes_[slot] = hash;
+  visited->count_++;
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Lists the legal moves worth searching as move_vars, in the order of
+/// generateMoves. A king on top of its own deck is not moved to an empty
+/// deck, and of all empty tableau decks only the first one is tried, as
+/// they are all alike.
+///
+/// @param board the decks of the game
+/// @param moves room for MAX_MOVES move_vars
+///
+/// @return number of moves listed
+//
+int listCandidateMoves(Board* board, int* moves)
+{
+  int i;
+  int desired_deck;
+  int kept = 0;
+  int empty_tried = -1;
+  int count = generateMoves(board, moves);
+  Card *wanted_card;
+  for (i = 0; i < count; i++)
+  {
+    wanted_card = findCardFromMoveVar(moves[i], board);
+    desired_deck = moves[i] / 100;
+    if ((desired_deck < 5) && (board->deck_[desired_deck] == NULL))
+    {
+      if ((empty_tried == moves[i] % 100) ||
+          ((wanted_card->prev_ == NULL) && (wanted_card->deck_ > 0)))
+      {
+        continue;
+      }
+      empty_tried = moves[i] % 100;
+    }
+    moves[kept++] = moves[i];
+  }
+  return kept;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Depth first search over all legal moves. Every position is searched only
+/// once, later transpositions are cut off by the visited table.
+///
+/// @param board the decks of the game
+/// @param card_instance array of cards in the double-linked list
+/// @param visited the table of searched positions
+/// @param solution the moves that lead to the current position
+/// @param depth number of moves made so far
+///
+/// @return 0 if the position can not be won
+/// @return 1 if the position can be won, solution holds the moves
+/// @return 2 if out of memory
+//
+int searchPosition(Board* board, Card* card_instance, VisitedTable* visited,
+                   Solution* solution, int depth)
+{
+  int i;
+  int count;
+  int err_var;
+  int current_deck;
+  int moves[MAX_MOVES];
+  unsigned char key[KEY_SIZE];
+  Card *wanted_card;
+  if (checkForWin(board) == 1)
+  {
+    solution->length_ = depth;
+    return 1;
+  }
+  err_var = probeTablebase(board);
+  if (err_var == 0)
+  {
+    return 0;
+  }
+  else if (err_var > 0)
+  {
+    if (reserveSolution(solution, depth + err_var) != 0)
+    {
+      printf("[ERR] Out of memory\n");
+      return 2;
+    }
+    err_var = followTablebase(board, &solution->moves_[depth]);
+    if (err_var >= 0)
+    {
+      solution->length_ = depth + err_var;
+      return 1;
+    }
+  }
+  encodePosition(board, card_instance, key);
+  err_var = insertPosition(visited, key, canonicalHash(board));
+  if (err_var != 0)
+  {
+    return (err_var == 1) ? 0 : 2;
+  }
+  if (reserveSolution(solution, depth) != 0)
+  {
+    printf("[ERR] Out of memory\n");
+    return 2;
+  }
+  count = listCandidateMoves(board, moves);
+  for (i = 0; i < count; i++)
+  {
+    wanted_card = findCardFromMoveVar(moves[i], board);
+    current_deck = travelToTheTop(wanted_card);
+    moveCards(board, wanted_card, current_deck, moves[i] / 100);
+    solution->moves_[depth] = moves[i];
+    err_var = searchPosition(board, card_instance, visited, solution,
+                             depth + 1);
+    unmakeMove(board, wanted_card, current_deck);
+    if (err_var != 0)
+    {
+      return err_var;
+    }
+  }
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Searches all positions reachable from the current one. The board is the
+/// same as before once the function returns. With an arena the visited
+/// table and the moves are allocated there, so solving deal after deal with
+/// the same arena, reset in between, does not call malloc again.
+///
+/// @param board the decks of the game
+/// @param card_instance array of cards in the double-linked list
+/// @param solution filled with the winning moves, see freeSolution
+/// @param arena the arena or NULL
+///
+/// @return 0 if the game can not be won
+/// @return 1 if the game can be won
+/// @return 2 if out of memory
+//
+int solveGame(Board* board, Card* card_instance, Solution* solution,
+              Arena* arena)
+{
+  int err_var;
+  VisitedTable visited;
+  visited.keys_ = NULL;
+  visited.hashes_ = NULL;
+  visited.size_ = 0;
+  visited.count_ = 0;
+  visited.arena_ = arena;
+  solution->moves_ = NULL;
+  solution->length_ = 0;
+  solution->capacity_ = 0;
+  solution->arena_ = arena;
+  err_var = searchPosition(board, card_instance, &visited, solution, 0);
+  if (arena == NULL)
+  {
+    free(visited.keys_);
+    free(visited.hashes_);
+  }
+  return err_var;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Frees the moves of a solution, unless they are in an arena.
+///
+/// @param solution the solution
+//
+void freeSolution(Solution* solution)
+{
+  if (solution->arena_ == NULL)
+  {
+    free(solution->moves_);
+  }
+  solution->moves_ = NULL;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Makes room for at least length + 1 moves in a solution. The moves grow to
+/// twice the room, in the arena of the solution if it has one.
+///
+/// @param solution the solution
+/// @param length number of moves that must fit before the next one
+///
+/// @return 0 if there is room
+/// @return 2 if out of memory
+//
+int reserveSolution(Solution* solution, int length)
+{
+  int *path;
+  if (length < solution->capacity_)
+  {
+    return 0;
+  }
+  if (solution->arena_ != NULL)
+  {
+    path = (int*)allocateArena(solution->arena_,
+                               2 * (length + 32) * sizeof(int));
+    if ((path != NULL) && (solution->capacity_ > 0))
+    {
+      memcpy(path, solution->moves_, solution->capacity_ * sizeof(int));
+    }
+  }
+  else
+  {
+    path = (int*)realloc(solution->moves_, 2 * (length + 32) * sizeof(int));
+  }
+  if (path == NULL)
+  {
+    return 2;
+  }
+  solution->moves_ = path;
+  solution->capacity_ = 2 * (length + 32);
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Solves the game from the current position and prints the result
+/// together with one list of winning moves.
+///
+/// @param board the decks of the game
+/// @param card_instance array of cards in the double-linked list
+/// @param threads number of threads searching, 1 for the plain search
+/// @param arena the arena the search may use, or NULL
+///
+/// @return 1 if solving was successful
+/// @return 2 if out of memory
+//
+int solveFromPosition(Board* board, Card* card_instance, int threads,
+                      Arena* arena)
+{
+  int i;
+  int err_var;
+  Solution solution;
+  err_var = solveDeal(board, card_instance, &solution, threads, arena);
+  if (err_var == 2)
+  {
+    freeSolution(&solution);
+    return 2;
+  }
+  else if (err_var == 0)
+  {
+    printf("[INFO] Game can not be won!\n");
+  }
+  else
+  {
+    printf("[INFO] Game can be won in %d moves:\n", solution.length_);
+    for (i = 0; i < solution.length_; i++)
+    {
+      printMoveCommand(solution.moves_[i]);
+    }
+  }
+  freeSolution(&solution);
+  return 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Solves the game from the current position with the plain search or, for
+/// more than one thread, with the parallel one. At the start of a deal the
+/// cache of --cache is asked first, and what was solved is stored there.
+///
+/// @param board the decks of the game
+/// @param card_instance array of cards in the double-linked list
+/// @param solution gets the winning moves, see freeSolution
+/// @param threads number of threads searching
+/// @param arena the arena the plain search uses, or NULL
+///
+/// @return 1 if the game can be won
+/// @return 0 if it can not be won
+/// @return 2 if out of memory
+//
+int solveDeal(Board* board, Card* card_instance, Solution* solution,
+              int threads, Arena* arena)
+{
+  int err_var;
+  int start = (deal_cache != NULL) &&
+              (checkDealStart(board, card_instance) == 1);
+  if (start == 1)
+  {
+    err_var = findCachedDeal(deal_cache, card_instance, solution, arena);
+    if (err_var != -1)
+    {
+      return err_var;
+    }
+  }
+  if (threads > 1)
+  {
+    err_var = solveGameParallel(board, card_instance, solution, threads);
+  }
+  else
+  {
+    err_var = solveGame(board, card_instance, solution, arena);
+  }
+  // the cache only saves time, a deal that was not stored is solved again
+  if ((start == 1) && (err_var != 2) &&
+      (storeCachedDeal(deal_cache, card_instance, err_var, solution) > 1))
+  {
+    reportCacheFailure(deal_cache);
+  }
+  return err_var;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Starts the thread that searches hints for a game, it begins with the
+/// position the game is in.
+///
+/// @param hint the engine
+/// @param game the game, it has to be started
+///
+/// @return 0 if the thread was started
+/// @return 1 if it could not be started
+//
+int startHintEngine(HintEngine* hint, Game* game)
+{
+  memset(hint, 0, sizeof(HintEngine));
+  memcpy(hint->card_instance_, game->card_instance_, 26 * sizeof(Card));
+  atomic_init(&hint->stop_, 0);
+  pthread_mutex_init(&hint->lock_, NULL);
+  pthread_cond_init(&hint->wake_, NULL);
+  hint->result_ = HINT_SEARCHING;
+  updateHint(hint, game, 0);
+  if (pthread_create(&hint->thread_, NULL, hintWorkerFunction, hint) != 0)
+  {
+    pthread_cond_destroy(&hint->wake_);
+    pthread_mutex_destroy(&hint->lock_);
+    return 1;
+  }
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Stops the thread of a hint engine and frees what it allocated.
+///
+/// @param hint the engine
+//
+void stopHintEngine(HintEngine* hint)
+{
+  pthread_mutex_lock(&hint->lock_);
+  hint->quit_ = 1;
+  atomic_store(&hint->stop_, 1);
+  pthread_cond_signal(&hint->wake_);
+  pthread_mutex_unlock(&hint->lock_);
+  pthread_join(hint->thread_, NULL);
+  freeArena(&hint->arena_);
+  free(hint->line_.moves_);
+  pthread_cond_destroy(&hint->wake_);
+  pthread_mutex_destroy(&hint->lock_);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Tells the hint engine that the game is in a new position. If the move
+/// made is the next one of the winning line found, the rest of the line is
+/// kept. After a move from a position that can not be won the game still
+/// can not be won. Otherwise the search starts over from the new position.
+///
+/// @param hint the engine
+/// @param game the game
+/// @param move_var the move made, 0 for undo, redo or a new game
+//
+void updateHint(HintEngine* hint, Game* game, int move_var)
+{
+  int moves[MAX_MOVES];
+  pthread_mutex_lock(&hint->lock_);
+  hint->generation_++;
+  if ((hint->result_ == 1) && (move_var != 0) &&
+      (hint->line_position_ < hint->line_.length_) &&
+      (hint->line_.moves_[hint->line_position_] == move_var))
+  {
+    hint->line_position_++;
+  }
+  else if ((hint->result_ != 0) || (move_var == 0))
+  {
+    saveSnapshot(&game->board_, game->card_instance_, &hint->position_);
+    hint->guess_ = (listCandidateMoves(&game->board_, moves) > 0) ?
+                   moves[0] : 0;
+    hint->result_ = (hint->guess_ == 0) ? 0 : HINT_SEARCHING;
+    atomic_store(&hint->stop_, 1);
+    pthread_cond_signal(&hint->wake_);
+  }
+  pthread_mutex_unlock(&hint->lock_);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Prints the best move the hint engine knows right now, without waiting
+/// for the search.
+///
+/// @param hint the engine
+//
+void printHint(HintEngine* hint)
+{
+  char command[LINE_SIZE];
+  pthread_mutex_lock(&hint->lock_);
+  if (hint->result_ == 1)
+  {
+    formatMoveCommand(hint->line_.moves_[hint->line_position_], command);
+    printf("[INFO] Hint: %s", command);
+  }
+  else if (hint->result_ == 0)
+  {
+    printf("[INFO] Game can not be won!\n");
+  }
+  else if (hint->result_ == 2)
+  {
+    printf("[INFO] Hint is not available!\n");
+  }
+  else
+  {
+    formatMoveCommand(hint->guess_, command);
+    printf("[INFO] Hint, still searching: %s", command);
+  }
+  pthread_mutex_unlock(&hint->lock_);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// The thread of a hint engine. Whenever there is a position it has not
+/// searched yet, it searches it as solveGame does and drops the search as
+/// soon as the game moves on. A deal in the cache of --cache is not
+/// searched at its start. The visited table and the path are in the
+/// arena of the engine, which is reset for every search.
+///
+/// @param argument the HintEngine
+///
+/// @return NULL
+//
+void* hintWorkerFunction(void* argument)
+{
+  HintEngine *hint = (HintEngine*)argument;
+  Snapshot position;
+  VisitedTable visited;
+  Solution path;
+  int *moves;
+  int err_var;
+  int start;
+  pthread_mutex_lock(&hint->lock_);
+  while (hint->quit_ == 0)
+  {
+    if ((hint->result_ != HINT_SEARCHING) ||
+        (hint->searched_ == hint->generation_))
+    {
+      pthread_cond_wait(&hint->wake_, &hint->lock_);
+      continue;
+    }
+    hint->searching_ = hint->generation_;
+    position = hint->position_;
+    atomic_store(&hint->stop_, 0);
+    pthread_mutex_unlock(&hint->lock_);
+    restoreSnapshot(&hint->board_, hint->card_instance_, &position);
+    resetArena(&hint->arena_);
+    memset(&visited, 0, sizeof(VisitedTable));
+    visited.arena_ = &hint->arena_;
+    memset(&path, 0, sizeof(Solution));
+    path.arena_ = &hint->arena_;
+    hint->best_deposited_ = -1;
+    start = (deal_cache != NULL) &&
+            (checkDealStart(&hint->board_, hint->card_instance_) == 1);
+    err_var = (start == 1) ? findCachedDeal(deal_cache, hint->card_instance_,
+                                            &path, &hint->arena_) : -1;
+    if (err_var == -1)
+    {
+      err_var = searchHint(hint, &visited, &path, 0);
+      if ((start == 1) && ((err_var == 0) || (err_var == 1)) &&
+          (storeCachedDeal(deal_cache, hint->card_instance_, err_var,
+                           &path) > 1))
+      {
+        reportCacheFailure(deal_cache);
+      }
+    }
+    pthread_mutex_lock(&hint->lock_);
+    hint->searched_ = hint->searching_;
+    if ((err_var == 3) || (hint->searching_ != hint->generation_))
+    {
+      continue;
+    }
+    if ((err_var == 1) && (hint->line_.capacity_ < path.length_))
+    {
+      moves = (int*)realloc(hint->line_.moves_, path.length_ * sizeof(int));
+      if (moves == NULL)
+      {
+        err_var = 2;
+      }
+      else
+      {
+        hint->line_.moves_ = moves;
+        hint->line_.capacity_ = path.length_;
+      }
+    }
+    if (err_var == 1)
+    {
+      memcpy(hint->line_.moves_, path.moves_, path.length_ * sizeof(int));
+      hint->line_.length_ = path.length_;
+      hint->line_position_ = 0;
+    }
+    hint->result_ = err_var;
+  }
+  pthread_mutex_unlock(&hint->lock_);
+  return NULL;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// The search of the hint engine, searchPosition on the board of the
+/// engine. It stops once the engine tells it to, and whenever it reaches a
+/// position with more cards on the deposit decks than before, the first
+/// move of the path becomes the guess of the engine.
+///
+/// @param hint the engine
+/// @param visited the table of searched positions
+/// @param path the moves that lead to the current position
+/// @param depth number of moves made so far
+///
+/// @return 0 if the position can not be won
+/// @return 1 if the position can be won, path holds the moves
+/// @return 2 if out of memory
+/// @return 3 if the search was stopped
+//
+int searchHint(HintEngine* hint, VisitedTable* visited, Solution* path,
+               int depth)
+{
+  int i;
+  int count;
+  int err_var;
+  int current_deck;
+  int deposited;
+  int moves[MAX_MOVES];
+  unsigned char key[KEY_SIZE];
+  Board *board = &hint->board_;
+  Card *wanted_card;
+  if (atomic_load_explicit(&hint->stop_, memory_order_relaxed) != 0)
+  {
+    return 3;
+  }
+  if (checkForWin(board) == 1)
+  {
+    path->length_ = depth;
+    return 1;
+  }
+  err_var = probeTablebase(board);
+  if (err_var == 0)
+  {
+    return 0;
+  }
+  else if (err_var > 0)
+  {
+    if (reserveSolution(path, depth + err_var) != 0)
+    {
+      return 2;
+    }
+    err_var = followTablebase(board, &path->moves_[depth]);
+    if (err_var >= 0)
+    {
+      path->length_ = depth + err_var;
+      return 1;
+    }
+  }
+  deposited = ((board->tail_[5] == NULL) ? 0 : board->tail_[5]->depth_ + 1) +
+              ((board->tail_[6] == NULL) ? 0 : board->tail_[6]->depth_ + 1);
+  if ((depth > 0) && (deposited > hint->best_deposited_))
+  {
+    hint->best_deposited_ = deposited;
+    pthread_mutex_lock(&hint->lock_);
+    if (hint->searching_ == hint->generation_)
+    {
+      hint->guess_ = path->moves_[0];
+    }
+    pthread_mutex_unlock(&hint->lock_);
+  }
+  encodePosition(board, hint->card_instance_, key);
+  err_var = insertPosition(visited, key, canonicalHash(board));
+  if (err_var != 0)
+  {
+    return (err_var == 1) ? 0 : 2;
+  }
+  if (reserveSolution(path, depth) != 0)
+  {
+    return 2;
+  }
+  count = listCandidateMoves(board, moves);
+  for (i = 0; i < count; i++)
+  {
+    wanted_card = findCardFromMoveVar(moves[i], board);
+    current_deck = travelToTheTop(wanted_card);
+    moveCards(board, wanted_card, current_deck, moves[i] / 100);
+    path->moves_[depth] = moves[i];
+    err_var = searchHint(hint, visited, path, depth + 1);
+    unmakeMove(board, wanted_card, current_deck);
+    if (err_var != 0)
+    {
+      return err_var;
+    }
+  }
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Estimates how often every legal move of a position wins by playing
+/// random games from it, on one thread per processor. Every playout starts
+/// with its move and goes on with playRollout. Up to ROLLOUT_PLAYOUTS are
+/// played per move, fewer if ROLLOUT_TIME is over first. The seed of every
+/// playout comes from the position and its number, so once all playouts
+/// finish the result does not depend on the number of threads. How many
+/// finish before ROLLOUT_TIME does. The board is not changed.
+///
+/// @param board the decks of the game
+/// @param card_instance array of cards in the double-linked list
+/// @param rollout gets the moves and their wins and playouts
+///
+/// @return number of moves ranked
+//
+int rankMoves(Board* board, Card* card_instance, Rollout* rollout)
+{
+  int i;
+  int started;
+  pthread_t threads[MAX_THREADS];
+  long processors = sysconf(_SC_NPROCESSORS_ONLN);
+  int count = (processors < 1) ? 1 : (processors > MAX_THREADS) ?
+              MAX_THREADS : (int)processors;
+  saveSnapshot(board, card_instance, &rollout->root_);
+  memcpy(rollout->card_instance_, card_instance, 26 * sizeof(Card));
+  rollout->count_ = generateMoves(board, rollout->moves_);
+  rollout->playouts_ = (long)rollout->count_ * ROLLOUT_PLAYOUTS;
+  rollout->deadline_ = readClock() + ROLLOUT_TIME;
+  rollout->seed_ = board->hash_;
+  atomic_init(&rollout->next_, 0);
+  for (i = 0; i < rollout->count_; i++)
+  {
+    atomic_init(&rollout->wins_[i], 0);
+    atomic_init(&rollout->played_[i], 0);
+  }
+  for (started = 0; started < count; started++)
+  {
+    if (pthread_create(&threads[started], NULL, rolloutWorkerFunction,
+                       rollout) != 0)
+    {
+      break;
+    }
+  }
+  if (started == 0)
+  {
+    // no thread could be started, the calling thread does the work
+    rolloutWorkerFunction(rollout);
+  }
+  for (i = 0; i < started; i++)
+  {
+    pthread_join(threads[i], NULL);
+  }
+  return rollout->count_;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// A thread of rankMoves. Takes playouts until all are played or the time
+/// is over, plays them on its own copy of the cards and adds up the wins.
+///
+/// @param argument the Rollout
+///
+/// @return NULL
+//
+void* rolloutWorkerFunction(void* argument)
+{
+  Rollout *rollout = (Rollout*)argument;
+  Card card_instance[26];
+  Board board;
+  Card *wanted_card;
+  long first;
+  long i;
+  int move;
+  unsigned long long seen[ROLLOUT_SEEN];
+  memcpy(card_instance, rollout->card_instance_, 26 * sizeof(Card));
+  while (readClock() < rollout->deadline_)
+  {
+    first = atomic_fetch_add(&rollout->next_, ROLLOUT_CHUNK);
+    if (first >= rollout->playouts_)
+    {
+      break;
+    }
+    for (i = first; (i < first + ROLLOUT_CHUNK) && (i < rollout->playouts_);
+         i++)
+    {
+      move = (int)(i % rollout->count_);
+      restoreSnapshot(&board, card_instance, &rollout->root_);
+      wanted_card = findCardFromMoveVar(rollout->moves_[move], &board);
+      moveCards(&board, wanted_card, travelToTheTop(wanted_card),
+                rollout->moves_[move] / 100);
+      if (playRollout(&board, mixHash(rollout->seed_ ^ (unsigned long long)i),
+                      seen) == 1)
+      {
+        atomic_fetch_add(&rollout->wins_[move], 1);
+      }
+      atomic_fetch_add(&rollout->played_[move], 1);
+    }
+  }
+  return NULL;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Plays one random game from a position to its end. A move to a deposit
+/// deck is always made when there is one, otherwise one of the moves of
+/// listCandidateMoves is picked at random. Moves back to a position of this
+/// game are not made, and a game with no other move left or with more than
+/// ROLLOUT_MOVES moves is lost. Once the game reaches the tablebase its
+/// result is known.
+///
+/// @param board the decks of the game, it is changed
+/// @param seed the start of the random numbers
+/// @param seen room for ROLLOUT_SEEN hashes of positions
+///
+/// @return 1 if the game was won
+/// @return 0 if it was lost
+//
+int playRollout(Board* board, unsigned long long seed,
+                unsigned long long* seen)
+{
+  int i;
+  int step;
+  int count;
+  int fresh;
+  int value;
+  int current_deck;
+  int moves[MAX_MOVES];
+  Card *wanted_card;
+  memset(seen, 0, ROLLOUT_SEEN * sizeof(unsigned long long));
+  checkSeenPosition(seen, board->hash_, 1);
+  for (step = 0; step < ROLLOUT_MOVES; step++)
+  {
+    if (checkForWin(board) == 1)
+    {
+      return 1;
+    }
+    value = probeTablebase(board);
+    if (value >= 0)
+    {
+      return (value > 0);
+    }
+    count = listCandidateMoves(board, moves);
+    fresh = 0;
+    for (i = 0; i < count; i++)
+    {
+      wanted_card = findCardFromMoveVar(moves[i], board);
+      current_deck = travelToTheTop(wanted_card);
+      moveCards(board, wanted_card, current_deck, moves[i] / 100);
+      if (checkSeenPosition(seen, board->hash_, 0) == 0)
+      {
+        moves[fresh++] = moves[i];
+      }
+      unmakeMove(board, wanted_card, current_deck);
+    }
+    if (fresh == 0)
+    {
+      return 0;
+    }
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    // deposit moves come first, see generateMoves
+    i = (moves[0] / 100 > 4) ? 0 : (int)(seed % (unsigned long long)fresh);
+    wanted_card = findCardFromMoveVar(moves[i], board);
+    moveCards(board, wanted_card, travelToTheTop(wanted_card),
+              moves[i] / 100);
+    checkSeenPosition(seen, board->hash_, 1);
+  }
+  return checkForWin(board);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Looks a position up in the small hash set of a playout. Once the set is
+/// full every position counts as seen, which ends the playout.
+///
+/// @param seen ROLLOUT_SEEN hashes, 0 is an empty slot
+/// @param hash the hash of the position
+/// @param insert 1 to add the position if it is not in the set
+///
+/// @return 1 if the position is in the set
+/// @return 0 if it is not
+//
+int checkSeenPosition(unsigned long long* seen, unsigned long long hash,
+                      int insert)
+{
+  int probes;
+  size_t slot = (size_t)(hash & (ROLLOUT_SEEN - 1));
+  for (probes = 0; probes < ROLLOUT_SEEN; probes++)
+  {
+    if (seen[slot] == hash)
+    {
+      return 1;
+    }
+    if (seen[slot] == 0)
+    {
+      if (insert == 1)
+      {
+        seen[slot] = hash;
+      }
+      return 0;
+    }
+    slot = (slot + 1) & (ROLLOUT_SEEN - 1);
+  }
+  return 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Prints the moves of a rollout by how often their playouts were won, the
+/// best first, as "[INFO] <percent>% of <playouts>: <move command>".
+///
+/// @param rollout the rollout after rankMoves
+//
+void printMoveRanking(Rollout* rollout)
+{
+  int order[MAX_MOVES];
+  int i;
+  int j;
+  int move;
+  long wins;
+  long played;
+  char command[LINE_SIZE];
+  if (rollout->count_ == 0)
+  {
+    printf("[INFO] No move left!\n");
+    return;
+  }
+  for (i = 0; i < rollout->count_; i++)
+  {
+    // insertion sort by wins / played, compared without dividing
+    move = i;
+    wins = atomic_load(&rollout->wins_[move]);
+    played = atomic_load(&rollout->played_[move]);
+    for (j = i; j > 0; j--)
+    {
+      if (atomic_load(&rollout->wins_[order[j - 1]]) * played >=
+          wins * atomic_load(&rollout->played_[order[j - 1]]))
+      {
+        break;
+      }
+      order[j] = order[j - 1];
+    }
+    order[j] = move;
+  }
+  for (i = 0; i < rollout->count_; i++)
+  {
+    move = order[i];
+    wins = atomic_load(&rollout->wins_[move]);
+    played = atomic_load(&rollout->played_[move]);
+    formatMoveCommand(rollout->moves_[move], command);
+    printf("[INFO] %5.1f%% of %ld: %s",
+           (played == 0) ? 0.0 : 100.0 * (double)wins / (double)played,
+           played, command);
+  }
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Counts all sequences of depth legal moves from the start of a game and
+/// prints "perft <depth>: <count>", with split first one line
+/// "<move command>: <count>" for every first move. Positions without moves
+/// before depth add nothing. The moves are made and taken back with
+/// makeMove and unmakeMove, nothing is rendered, so the counts check the
+/// rules and the time the speed of moving. The time goes to stderr.
+///
+/// @param game the game, it is not changed
+/// @param depth number of moves in a sequence
+/// @param split 1 to count the sequences of every first move by itself
+///
+/// @return 0 always
+//
+int mainPerftFunction(Game* game, int depth, int split)
+{
+  int i;
+  int count;
+  int length;
+  int moves[MAX_MOVES];
+  int current_deck;
+  char command[LINE_SIZE];
+  unsigned long long sequences;
+  unsigned long long total = 0;
+  unsigned long long made = 0;
+  long long start = readClock();
+  long long elapsed;
+  Board *board = &game->board_;
+  Card *wanted_card;
+  if ((split == 0) || (depth == 0))
+  {
+    total = countMoveSequences(board, depth, &made);
+  }
+  else
+  {
+    count = generateMoves(board, moves);
+    for (i = 0; i < count; i++)
+    {
+      wanted_card = findCardFromMoveVar(moves[i], board);
+      current_deck = wanted_card->deck_;
+      makeMove(board, wanted_card, current_deck, moves[i] / 100);
+      made++;
+      sequences = countMoveSequences(board, depth - 1, &made);
+      unmakeMove(board, wanted_card, current_deck);
+      total += sequences;
+      length = formatMoveCommand(moves[i], command);
+      command[length - 1] = '\0';
+      printf("%s: %llu\n", command, sequences);
+    }
+  }
+  elapsed = readClock() - start;
+  printf("perft %d: %llu\n", depth, total);
+  fprintf(stderr, "[INFO] %llu moves made in %.3f s, %.0f moves/s\n", made,
+          elapsed / 1e9, (elapsed == 0) ? 0.0 : made * 1e9 / elapsed);
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Counts the sequences of depth legal moves from a position, see
+/// mainPerftFunction. The board is the same as before once the function
+/// returns.
+///
+/// @param board the decks of the game
+/// @param depth number of moves left in a sequence
+/// @param made counts the moves made
+///
+/// @return number of sequences
+//
+unsigned long long countMoveSequences(Board* board, int depth,
+                                      unsigned long long* made)
+{
+  int i;
+  int count;
+  int current_deck;
+  int moves[MAX_MOVES];
+  unsigned long long sequences = 0;
+  Card *wanted_card;
+  if (depth == 0)
+  {
+    return 1;
+  }
+  count = generateMoves(board, moves);
+  for (i = 0; i < count; i++)
+  {
+    wanted_card = findCardFromMoveVar(moves[i], board);
+    current_deck = wanted_card->deck_;
+    makeMove(board, wanted_card, current_deck, moves[i] / 100);
+    (*made)++;
+    sequences += countMoveSequences(board, depth - 1, made);
+    unmakeMove(board, wanted_card, current_deck);
+  }
+  return sequences;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Runs every check of the engine against known results. Each check prints
+/// "[INFO] <check>: ok" or "[ERR] <check>: " and what went wrong, a failed
+/// check does not stop the others.
+///
+/// @return 0 if every check passed
+/// @return 1 if a check failed
+/// @return 2 if out of memory
+//
+int mainSelftestFunction(void)
+{
+  int i;
+  int err_var = 0;
+  int result;
+  int (*checks[])(void) = {checkPerftCounts, checkEndgameRanks,
+                           checkParallelSolve};
+  for (i = 0; i < (int)(sizeof(checks) / sizeof(checks[0])); i++)
+  {
+    result = checks[i]();
+    if (result == 2)
+    {
+      return 2;
+    }
+    err_var |= result;
+  }
+  return err_var;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Counts the move sequences of up to SELFTEST_PERFT_DEPTH moves from
+/// generated deal SELFTEST_PERFT_DEAL, one whose moves do not run out
+/// early, and compares them with the recorded counts. A different count
+/// means the rules or makeMove and unmakeMove changed.
+///
+/// @return 0 if all counts match
+/// @return 1 if one does not
+/// @return 2 if out of memory
+//
+int checkPerftCounts(void)
+{
+  int depth;
+  unsigned long long made = 0;
+  unsigned long long sequences;
+  static const unsigned long long counts[SELFTEST_PERFT_DEPTH + 1] = {
+    1, 5, 17, 43, 89, 161, 280, 600, 1568, 3968, 9792};
+  Game *game = newGame();
+  if (game == NULL)
+  {
+    printf("[ERR] Out of memory\n");
+    return 2;
+  }
+  generateDeal(SELFTEST_PERFT_DEAL, game->card_instance_);
+  startGame(game);
+  for (depth = 0; depth <= SELFTEST_PERFT_DEPTH; depth++)
+  {
+    sequences = countMoveSequences(&game->board_, depth, &made);
+    if (sequences != counts[depth])
+    {
+      printf("[ERR] perft: deal %d depth %d counted %llu, expected %llu\n",
+             SELFTEST_PERFT_DEAL, depth, sequences, counts[depth]);
+      freeGame(game);
+      return 1;
+    }
+  }
+  printf("[INFO] perft: ok\n");
+  freeGame(game);
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Turns every number of a tablebase with TABLEBASE_CARDS cards into its
+/// position with unrankEndgame and back with rankEndgame. Both have to give
+/// the same number, otherwise a tablebase built and probed by them is
+/// wrong.
+///
+/// @return 0 if all numbers come back
+/// @return 1 if one does not
+//
+int checkEndgameRanks(void)
+{
+  unsigned long long rank;
+  unsigned long long back;
+  unsigned long long count = countEndgames(TABLEBASE_CARDS);
+  EndgamePosition position;
+  for (rank = 0; rank < count; rank++)
+  {
+    unrankEndgame(rank, &position);
+    back = rankEndgame(&position);
+    if (back != rank)
+    {
+      printf("[ERR] endgame rank: %llu came back as %llu\n", rank, back);
+      return 1;
+    }
+  }
+  printf("[INFO] endgame rank: ok\n");
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Solves the first SELFTEST_SOLVE_DEALS generated deals and a few deals
+/// that can be won with solveGame and with solveGameParallel on
+/// SELFTEST_THREADS threads. Generated deals can hardly ever be won, the
+/// others make sure a win is found by both. Both have to give the same
+/// result, and the moves of the parallel search have to win the game.
+///
+/// @return 0 if all results agree
+/// @return 1 if one does not
+/// @return 2 if out of memory
+//
+int checkParallelSolve(void)
+{
+  int i;
+  int j;
+  int serial;
+  int parallel;
+  int played;
+  Solution solution;
+  static const unsigned char won_deals[][DEAL_SIZE] = {
+    {20, 7, 19, 6, 18, 11, 5, 4, 16, 3, 15, 2, 14, 1, 13, 0, 10, 17, 9, 8,
+     23, 24, 22, 21, 12, 25},
+    {11, 7, 19, 6, 18, 5, 17, 4, 16, 3, 15, 14, 2, 1, 13, 0, 10, 21, 9, 8,
+     24, 23, 22, 20, 12, 25},
+    {20, 7, 19, 6, 18, 5, 17, 4, 16, 12, 15, 2, 14, 1, 13, 0, 10, 11, 9, 8,
+     24, 23, 22, 21, 3, 25}};
+  int count = SELFTEST_SOLVE_DEALS +
+              (int)(sizeof(won_deals) / sizeof(won_deals[0]));
+  Game *game = newGame();
+  if (game == NULL)
+  {
+    printf("[ERR] Out of memory\n");
+    return 2;
+  }
+  for (i = 0; i < count; i++)
+  {
+    if (i < SELFTEST_SOLVE_DEALS)
+    {
+      generateDeal((unsigned long long)i, game->card_instance_);
+      startGame(game);
+    }
+    else
+    {
+      initGameFromDeal(game, won_deals[i - SELFTEST_SOLVE_DEALS]);
+    }
+    serial = solveGame(&game->board_, game->card_instance_, &solution, NULL);
+    freeSolution(&solution);
+    parallel = (serial == 2) ? 2 :
+               solveGameParallel(&game->board_, game->card_instance_,
+                                 &solution, SELFTEST_THREADS);
+    played = 0;
+    for (j = 0; (parallel == 1) && (j < solution.length_); j++)
+    {
+      played = applyMove(game, solution.moves_[j]);
+    }
+    freeSolution(&solution);
+    if ((serial == 2) || (parallel == 2) || (played == 2))
+    {
+      freeGame(game);
+      return 2;
+    }
+    if ((serial != parallel) || ((parallel == 1) && (played != 1)))
+    {
+      printf("[ERR] parallel solve: deal %d is %s with 1 thread and %s "
+             "with %d\n", i, (serial == 1) ? "won" : "lost",
+             (parallel == 1) ? ((played == 1) ? "won" : "a wrong win") :
+             "lost", SELFTEST_THREADS);
+      freeGame(game);
+      return 1;
+    }
+  }
+  printf("[INFO] parallel solve: ok\n");
+  freeGame(game);
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Builds the endgame tablebase of all positions with up to cards cards
+/// outside the deposit decks and writes it to a file: TABLEBASE_MAGIC, the
+/// number of cards in the next byte, zeros up to TABLEBASE_HEADER_SIZE and
+/// one byte per position as described at Tablebase.
+///
+/// The analysis goes backwards from the won position. Cards never leave
+/// the deposit decks, so every move keeps the number of cards outside them
+/// or lowers it by one and the positions of the tablebase only reach each
+/// other. All positions won in n moves are known after round n, and round
+/// n + 1 marks every position not marked yet from which one move reaches
+/// one of them, see markPredecessors. What is left unmarked can not be
+/// won.
+///
+/// @param path the file to write
+/// @param cards most cards outside the deposit decks, 0 to
+/// TABLEBASE_MAX_CARDS
+///
+/// @return 0 if the tablebase was written
+/// @return 1 if cards is out of range
+/// @return 2 if out of memory
+/// @return 3 if the file can not be written
+//
+int buildTablebase(char* path, int cards)
+{
+  unsigned long long size = countEndgames(cards);
+  unsigned long long rank;
+  unsigned long long won = 0;
+  unsigned char header[TABLEBASE_HEADER_SIZE];
+  unsigned char *table;
+  EndgamePosition position;
+  FILE *file;
+  int value;
+  int marked = 1;
+  if ((cards < 0) || (cards > TABLEBASE_MAX_CARDS))
+  {
+    return 1;
+  }
+  table = (unsigned char*)calloc(size, 1);
+  if (table == NULL)
+  {
+    printf("[ERR] Out of memory\n");
+    return 2;
+  }
+  table[0] = 1;
+  for (value = 1; (marked > 0) && (value < 255); value++)
+  {
+    marked = 0;
+    for (rank = 0; rank < size; rank++)
+    {
+      if (table[rank] == value)
+      {
+        unrankEndgame(rank, &position);
+        marked += markPredecessors(table, cards, &position, value + 1);
+      }
+    }
+  }
+  for (rank = 0; rank < size; rank++)
+  {
+    won += (table[rank] != 0);
+  }
+  memset(header, 0, TABLEBASE_HEADER_SIZE);
+  memcpy(header, TABLEBASE_MAGIC, strlen(TABLEBASE_MAGIC));
+  header[strlen(TABLEBASE_MAGIC)] = (unsigned char)cards;
+  file = fopen(path, "wb");
+  if ((file == NULL) ||
+      (fwrite(header, 1, TABLEBASE_HEADER_SIZE, file) !=
+       TABLEBASE_HEADER_SIZE) ||
+      (fwrite(table, 1, size, file) != size))
+  {
+    if (file != NULL)
+    {
+      fclose(file);
+    }
+    free(table);
+    printf("[ERR] Invalid file!\n");
+    return 3;
+  }
+  fclose(file);
+  free(table);
+  printf("[INFO] %llu positions with up to %d cards outside the deposit "
+         "decks, %llu can be won, in up to %d moves\n", size, cards, won,
+         value - 2);
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Marks every position of the tablebase from which one move reaches the
+/// given one. A card on top of a deposit deck may have come from the bottom
+/// of any other deck. A run at the bottom of a tableau deck that could have
+/// been moved there, as checkForValidMove checks, may have come from the
+/// bottom of any other tableau deck, and a single card from deck 0 as well.
+///
+/// @param table the tablebase being built
+/// @param cards most cards outside the deposit decks
+/// @param position the position reached
+/// @param value what the positions get if they are not marked yet
+///
+/// @return number of positions marked
+//
+int markPredecessors(unsigned char* table, int cards,
+                     EndgamePosition* position, int value)
+{
+  int start[5];
+  int color;
+  int deck;
+  int from_deck;
+  int first;
+  int length;
+  int i;
+  int k;
+  int number;
+  int marked = 0;
+  unsigned long long rank;
+  EndgamePosition before;
+  start[0] = 0;
+  for (deck = 1; deck < 5; deck++)
+  {
+    start[deck] = start[deck - 1] + position->length_[deck - 1];
+  }
+  for (color = 0; (color < 2) && (position->count_ < cards); color++)
+  {
+    if (((color == 0) ? position->red_ : position->black_) == 0)
+    {
+      continue;
+    }
+    number = (color == 0) ? position->red_ - 1 : position->black_ + 12;
+    for (from_deck = 0; from_deck < 5; from_deck++)
+    {
+      before = *position;
+      before.red_ -= (color == 0);
+      before.black_ -= (color == 1);
+      i = start[from_deck] + position->length_[from_deck];
+      memmove(&before.cards_[i + 1], &before.cards_[i],
+              position->count_ - i);
+      before.cards_[i] = (unsigned char)number;
+      before.count_++;
+      before.length_[from_deck]++;
+      rank = rankEndgame(&before);
+      if (table[rank] == 0)
+      {
+        table[rank] = (unsigned char)value;
+        marked++;
+      }
+    }
+  }
+  for (deck = 1; deck < 5; deck++)
+  {
+    // first goes up from the bottom card while the cards below it are a run
+    for (first = position->length_[deck] - 1; first >= 0; first--)
+    {
+      i = start[deck] + first;
+      number = position->cards_[i];
+      if ((first < position->length_[deck] - 1) &&
+          (((number < 13) == (position->cards_[i + 1] < 13)) ||
+           (number % 13 != position->cards_[i + 1] % 13 + 1)))
+      {
+        break;
+      }
+      if ((first == 0) ? (number % 13 != 12) :
+          (((number < 13) == (position->cards_[i - 1] < 13)) ||
+           (position->cards_[i - 1] % 13 != number % 13 + 1)))
+      {
+        continue;
+      }
+      length = position->length_[deck] - first;
+      for (from_deck = 0; from_deck < 5; from_deck++)
+      {
+        if ((from_deck == deck) || ((from_deck == 0) && (length > 1)))
+        {
+          continue;
+        }
+        before = *position;
+        before.length_[deck] -= length;
+        before.length_[from_deck] += length;
+        for (k = 0, i = 0; k < 5; k++)
+        {
+          if (k != deck)
+          {
+            memcpy(&before.cards_[i], &position->cards_[start[k]],
+                   position->length_[k]);
+            i += position->length_[k];
+          }
+          else
+          {
+            memcpy(&before.cards_[i], &position->cards_[start[k]], first);
+            i += first;
+          }
+          if (k == from_deck)
+          {
+            memcpy(&before.cards_[i], &position->cards_[start[deck] + first],
+                   length);
+            i += length;
+          }
+        }
+        rank = rankEndgame(&before);
+        if (table[rank] == 0)
+        {
+          table[rank] = (unsigned char)value;
+          marked++;
+        }
+      }
+    }
+  }
+  return marked;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Maps a tablebase file written by buildTablebase.
+///
+/// @param path the file
+/// @param table gets the mapped tablebase
+///
+/// @return 0 if the tablebase was mapped
+/// @return 3 if the file is not a tablebase
+//
+int openTablebase(char* path, Tablebase* table)
+{
+  struct stat info;
+  int file = open(path, O_RDONLY);
+  if (file < 0)
+  {
+    return 3;
+  }
+  if ((fstat(file, &info) != 0) || (info.st_size < TABLEBASE_HEADER_SIZE))
+  {
+    close(file);
+    return 3;
+  }
+  table->size_ = (size_t)info.st_size;
+  table->data_ = (unsigned char*)mmap(NULL, table->size_, PROT_READ,
+                                      MAP_PRIVATE, file, 0);
+  close(file);
+  if (table->data_ == MAP_FAILED)
+  {
+    return 3;
+  }
+  table->cards_ = table->data_[strlen(TABLEBASE_MAGIC)];
+  if ((memcmp(table->data_, TABLEBASE_MAGIC, strlen(TABLEBASE_MAGIC)) != 0) ||
+      (table->cards_ > TABLEBASE_MAX_CARDS) ||
+      (table->size_ != TABLEBASE_HEADER_SIZE + countEndgames(table->cards_)))
+  {
+    munmap(table->data_, table->size_);
+    return 3;
+  }
+  table->table_ = &table->data_[TABLEBASE_HEADER_SIZE];
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Unmaps a tablebase mapped by openTablebase.
+///
+/// @param table the tablebase
+//
+void closeTablebase(Tablebase* table)
+{
+  munmap(table->data_, table->size_);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Looks a position up in the tablebase of --tablebase.
+///
+/// @param board the decks of the game
+///
+/// @return -1 if there is no tablebase or the position is not in it
+/// @return 0 if the position can not be won
+/// @return n + 1 if it can be won in n moves, see followTablebase
+//
+int probeTablebase(Board* board)
+{
+  EndgamePosition position;
+  if ((tablebase == NULL) || (readEndgame(board, &position) != 0))
+  {
+    return -1;
+  }
+  return tablebase->table_[rankEndgame(&position)];
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Writes the shortest winning moves of a position that probeTablebase
+/// says can be won. The board is the same as before once the function
+/// returns. Only a tablebase file that does not fit the rules, broken or
+/// written by another version, can lead to no win.
+///
+/// @param board the decks of the game
+/// @param moves room for the moves, one less than probeTablebase returned
+///
+/// @return number of moves written
+/// @return -1 if the moves of the tablebase do not win
+//
+int followTablebase(Board* board, int* moves)
+{
+  int i;
+  int count = 0;
+  int length;
+  int next[MAX_MOVES];
+  int from_decks[TABLEBASE_MOVES];
+  int value = probeTablebase(board);
+  Card *wanted_card;
+  for (length = 0; length < value - 1; length++)
+  {
+    count = generateMoves(board, next);
+    for (i = 0; i < count; i++)
+    {
+      wanted_card = findCardFromMoveVar(next[i], board);
+      from_decks[length] = wanted_card->deck_;
+      moveCards(board, wanted_card, from_decks[length], next[i] / 100);
+      if (probeTablebase(board) == value - 1 - length)
+      {
+        break;
+      }
+      unmakeMove(board, wanted_card, from_decks[length]);
+    }
+    if (i == count)
+    {
+      break;
+    }
+    moves[length] = next[i];
+  }
+  count = (checkForWin(board) == 1) ? length : -1;
+  for (i = length - 1; i >= 0; i--)
+  {
+    unmakeMove(board, findCardFromMoveVar(moves[i], board), from_decks[i]);
+  }
+  return count;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Reads the position of a board as a tablebase position.
+///
+/// @param board the decks of the game
+/// @param position gets the position
+///
+/// @return 0 if the position is in the tablebase of --tablebase
+/// @return -1 if more cards are outside the deposit decks
+//
+int readEndgame(Board* board, EndgamePosition* position)
+{
+  int deck;
+  Card *ptr;
+  position->red_ = 0;
+  position->black_ = 0;
+  for (deck = 5; deck < 7; deck++)
+  {
+    if (board->deck_[deck] == NULL)
+    {
+      continue;
+    }
+    if (board->deck_[deck]->color_ == 'R')
+    {
+      position->red_ = board->tail_[deck]->depth_ + 1;
+    }
+    else
+    {
+      position->black_ = board->tail_[deck]->depth_ + 1;
+    }
+  }
+  position->count_ = 26 - position->red_ - position->black_;
+  if (position->count_ > tablebase->cards_)
+  {
+    return -1;
+  }
+  position->count_ = 0;
+  for (deck = 0; deck < 5; deck++)
+  {
+    position->length_[deck] = 0;
+    for (ptr = board->deck_[deck]; ptr != NULL; ptr = ptr->next_)
+    {
+      position->cards_[position->count_++] = (unsigned char)getCardNumber(ptr);
+      position->length_[deck]++;
+    }
+  }
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Numbers the positions of the tablebase without gaps: first by the
+/// number of cards outside the deposit decks, then by how many of them are
+/// red, then by the number of cards on every deck and last by the order of
+/// the cards, as a Lehmer code.
+///
+/// @param position the position
+///
+/// @return the number of the position
+//
+unsigned long long rankEndgame(EndgamePosition* position)
+{
+  int i;
+  int j;
+  int x;
+  int left = position->count_;
+  int smaller;
+  unsigned long long factorial = 1;
+  unsigned long long lengths = 0;
+  unsigned long long order = 0;
+  for (i = 0; i < 4; i++)
+  {
+    for (x = 0; x < position->length_[i]; x++)
+    {
+      lengths += countCombinations(left - x + 3 - i, 3 - i);
+    }
+    left -= position->length_[i];
+  }
+  for (i = 0; i < position->count_; i++)
+  {
+    smaller = 0;
+    for (j = i + 1; j < position->count_; j++)
+    {
+      smaller += (position->cards_[j] < position->cards_[i]);
+    }
+    order = order * (position->count_ - i) + smaller;
+    factorial *= i + 1;
+  }
+  return countEndgames(position->count_ - 1) +
+         ((13 - position->red_) *
+          countCombinations(position->count_ + 4, 4) + lengths) *
+         factorial + order;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Turns the number of a tablebase position back into the position, see
+/// rankEndgame.
+///
+/// @param rank the number of the position
+/// @param position gets the position
+//
+void unrankEndgame(unsigned long long rank, EndgamePosition* position)
+{
+  int i;
+  int j;
+  int x;
+  int left;
+  int count = 0;
+  int digits[TABLEBASE_MAX_CARDS];
+  unsigned char outside[TABLEBASE_MAX_CARDS];
+  unsigned long long factorial = 1;
+  unsigned long long lengths;
+  unsigned long long size;
+  while (rank >= countEndgames(count))
+  {
+    count++;
+  }
+  rank -= countEndgames(count - 1);
+  for (i = 2; i <= count; i++)
+  {
+    factorial *= i;
+  }
+  position->count_ = count;
+  position->red_ = 13 - (int)(rank / (countCombinations(count + 4, 4) *
+                                      factorial));
+  position->black_ = 13 - count + (13 - position->red_);
+  lengths = (rank / factorial) % countCombinations(count + 4, 4);
+  rank %= factorial;
+  left = count;
+  for (i = 0; i < 4; i++)
+  {
+    for (x = 0; lengths >= (size = countCombinations(left - x + 3 - i,
+                                                     3 - i)); x++)
+    {
+      lengths -= size;
+    }
+    position->length_[i] = x;
+    left -= x;
+  }
+  position->length_[4] = left;
+  for (i = count - 1; i >= 0; i--)
+  {
+    digits[i] = (int)(rank % (count - i));
+    rank /= count - i;
+  }
+  for (i = 0; i < 13 - position->red_; i++)
+  {
+    outside[i] = (unsigned char)(position->red_ + i);
+  }
+  for (j = 0; i < count; i++, j++)
+  {
+    outside[i] = (unsigned char)(13 + position->black_ + j);
+  }
+  for (i = 0; i < count; i++)
+  {
+    position->cards_[i] = outside[digits[i]];
+    memmove(&outside[digits[i]], &outside[digits[i] + 1],
+            count - i - digits[i] - 1);
+  }
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Counts the positions of a tablebase, see rankEndgame. For n cards
+/// outside the deposit decks 0 to n of them can be red, there are
+/// (n + 4 choose 4) ways to put them on five decks and n! orders.
+///
+/// @param cards most cards outside the deposit decks, -1 for none
+///
+/// @return number of positions
+//
+unsigned long long countEndgames(int cards)
+{
+  int count;
+  unsigned long long factorial = 1;
+  unsigned long long positions = 0;
+  for (count = 0; count <= cards; count++)
+  {
+    factorial *= (count == 0) ? 1 : count;
+    positions += (count + 1) * countCombinations(count + 4, 4) * factorial;
+  }
+  return positions;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Computes a binomial coefficient.
+///
+/// @param count number of things
+/// @param chosen number of them chosen
+///
+/// @return count choose chosen
+//
+unsigned long long countCombinations(int count, int chosen)
+{
+  int i;
+  unsigned long long combinations = 1;
+  for (i = 0; i < chosen; i++)
+  {
+    combinations = combinations * (count - i) / (i + 1);
+  }
+  return combinations;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Opens a cache of solved deals, see DealCache. A file that does not exist
+/// yet is created.
+///
+/// @param path the file
+/// @param cache gets the cache, closeDealCache releases it
+///
+/// @return 0 if the cache is open
+/// @return 2 if out of memory
+/// @return 3 if the file is not a cache or can not be opened
+//
+int openDealCache(char* path, DealCache* cache)
+{
+  struct stat info;
+  int err_var = 3;
+  memset(cache, 0, sizeof(DealCache));
+  cache->file_ = open(path, O_RDWR | O_CREAT, 0644);
+  if (cache->file_ < 0)
+  {
+    return 3;
+  }
+  cache->slots_ = (size_t*)calloc(CACHE_SLOTS, sizeof(size_t));
+  if (cache->slots_ == NULL)
+  {
+    close(cache->file_);
+    printf("[ERR] Out of memory\n");
+    return 2;
+  }
+  cache->capacity_ = CACHE_SLOTS;
+  pthread_mutex_init(&cache->lock_, NULL);
+  flock(cache->file_, LOCK_EX);
+  if ((fstat(cache->file_, &info) == 0) &&
+      ((info.st_size > 0) ||
+       (write(cache->file_, CACHE_MAGIC, CACHE_HEADER_SIZE) ==
+        CACHE_HEADER_SIZE)))
+  {
+    err_var = indexCachedDeals(cache);
+  }
+  flock(cache->file_, LOCK_UN);
+  if (err_var != 0)
+  {
+    closeDealCache(cache);
+  }
+  return err_var;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Closes a cache opened by openDealCache.
+///
+/// @param cache the cache
+//
+void closeDealCache(DealCache* cache)
+{
+  if (cache->data_ != NULL)
+  {
+    munmap(cache->data_, cache->mapped_);
+  }
+  close(cache->file_);
+  free(cache->slots_);
+  pthread_mutex_destroy(&cache->lock_);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Looks a deal up in the cache. If it is not there, records other
+/// processes appended since are indexed and it is looked up again.
+///
+/// @param cache the cache
+/// @param card_instance array of cards as read by entireInputFromFile
+/// @param solution gets the winning moves, see freeSolution
+/// @param arena the arena for the moves, or NULL
+///
+/// @return -1 if the deal is not in the cache
+/// @return 0 if it can not be won
+/// @return 1 if it can be won
+/// @return 2 if out of memory
+//
+int findCachedDeal(DealCache* cache, Card* card_instance, Solution* solution,
+                   Arena* arena)
+{
+  int i;
+  int err_var = -1;
+  size_t offset;
+  unsigned char deal[DEAL_SIZE];
+  const unsigned char *record;
+  solution->moves_ = NULL;
+  solution->length_ = 0;
+  solution->capacity_ = 0;
+  solution->arena_ = arena;
+  encodeDeal(card_instance, deal);
+  pthread_mutex_lock(&cache->lock_);
+  offset = lookupCachedDeal(cache, deal);
+  if (offset == 0)
+  {
+    flock(cache->file_, LOCK_SH);
+    err_var = (indexCachedDeals(cache) == 2) ? 2 : -1;
+    flock(cache->file_, LOCK_UN);
+    offset = lookupCachedDeal(cache, deal);
+  }
+  if (offset != 0)
+  {
+    record = &cache->data_[offset];
+    err_var = record[DEAL_SIZE];
+    solution->length_ = record[DEAL_SIZE + 1] | (record[DEAL_SIZE + 2] << 8);
+    if ((solution->length_ > 0) &&
+        (reserveSolution(solution, solution->length_) != 0))
+    {
+      err_var = 2;
+      solution->length_ = 0;
+    }
+    for (i = 0; i < solution->length_; i++)
+    {
+      solution->moves_[i] = record[CACHE_RECORD_SIZE + 2 * i] |
+                            (record[CACHE_RECORD_SIZE + 2 * i + 1] << 8);
+    }
+  }
+  pthread_mutex_unlock(&cache->lock_);
+  if (err_var == 2)
+  {
+    printf("[ERR] Out of memory\n");
+  }
+  return err_var;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Appends a solved deal to the cache, unless it is there already. A
+/// record cut off by a process that died while writing it is dropped
+/// first, no other process writes while the file is locked. A solution of
+/// more than CACHE_MAX_MOVES moves does not fit the two bytes of a record
+/// and is not stored.
+///
+/// @param cache the cache
+/// @param card_instance array of cards as read by entireInputFromFile
+/// @param result 1 if the deal can be won, 0 if not
+/// @param solution the winning moves if it can be won
+///
+/// @return 0 if the deal is in the cache
+/// @return 1 if the solution is too long to store
+/// @return 2 if out of memory
+/// @return 3 if the file can not be written
+//
+int storeCachedDeal(DealCache* cache, Card* card_instance, int result,
+                    Solution* solution)
+{
+  int i;
+  int length = (result == 1) ? solution->length_ : 0;
+  int err_var = 0;
+  size_t size = CACHE_RECORD_SIZE + 2 * (size_t)length;
+  unsigned char *record;
+  if (length > CACHE_MAX_MOVES)
+  {
+    return 1;
+  }
+  record = (unsigned char*)malloc(size);
+  if (record == NULL)
+  {
+    return 2;
+  }
+  encodeDeal(card_instance, record);
+  record[DEAL_SIZE] = (unsigned char)result;
+  record[DEAL_SIZE + 1] = (unsigned char)(length & 0xff);
+  record[DEAL_SIZE + 2] = (unsigned char)(length >> 8);
+  for (i = 0; i < length; i++)
+  {
+    record[CACHE_RECORD_SIZE + 2 * i] =
+      (unsigned char)(solution->moves_[i] & 0xff);
+    record[CACHE_RECORD_SIZE + 2 * i + 1] =
+      (unsigned char)(solution->moves_[i] >> 8);
+  }
+  pthread_mutex_lock(&cache->lock_);
+  flock(cache->file_, LOCK_EX);
+  err_var = indexCachedDeals(cache);
+  if ((err_var == 0) && (lookupCachedDeal(cache, record) == 0))
+  {
+    if ((ftruncate(cache->file_, (off_t)cache->size_) != 0) ||
+        (pwrite(cache->file_, record, size, (off_t)cache->size_) !=
+         (ssize_t)size))
+    {
+      err_var = 3;
+    }
+    else
+    {
+      err_var = indexCachedDeals(cache);
+    }
+  }
+  flock(cache->file_, LOCK_UN);
+  pthread_mutex_unlock(&cache->lock_);
+  free(record);
+  return err_var;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Tells once per cache that solved deals could not be stored in it. It
+/// goes to stderr, so the results on stdout stay as they are.
+///
+/// @param cache the cache
+//
+void reportCacheFailure(DealCache* cache)
+{
+  pthread_mutex_lock(&cache->lock_);
+  if (cache->reported_ == 0)
+  {
+    fprintf(stderr, "[ERR] Solved deals can not be stored in the cache!\n");
+    cache->reported_ = 1;
+  }
+  pthread_mutex_unlock(&cache->lock_);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Maps the whole cache file and adds the records after size_ to the
+/// slots. A record that is not complete yet is left for later. The mapping
+/// may reach past the end of the file, those bytes are never read.
+///
+/// @param cache the cache, locked
+///
+/// @return 0 if the new records were indexed
+/// @return 2 if out of memory
+/// @return 3 if the file is not a cache or can not be read
+//
+int indexCachedDeals(DealCache* cache)
+{
+  struct stat info;
+  size_t end;
+  size_t size;
+  unsigned char *data;
+  const unsigned char *record;
+  if ((fstat(cache->file_, &info) != 0) ||
+      (info.st_size < CACHE_HEADER_SIZE))
+  {
+    return 3;
+  }
+  if ((size_t)info.st_size > cache->mapped_)
+  {
+    // twice the room, so appending deal after deal rarely maps again
+    size = 2 * (size_t)info.st_size + CACHE_MAP_SIZE;
+    data = (unsigned char*)mmap(NULL, size, PROT_READ, MAP_SHARED,
+                                cache->file_, 0);
+    if (data == MAP_FAILED)
+    {
+      return 3;
+    }
+    if (cache->data_ != NULL)
+    {
+      munmap(cache->data_, cache->mapped_);
+    }
+    cache->data_ = data;
+    cache->mapped_ = size;
+  }
+  if (cache->size_ == 0)
+  {
+    if (memcmp(cache->data_, CACHE_MAGIC, CACHE_HEADER_SIZE) != 0)
+    {
+      return 3;
+    }
+    cache->size_ = CACHE_HEADER_SIZE;
+  }
+  while (cache->size_ + CACHE_RECORD_SIZE <= (size_t)info.st_size)
+  {
+    record = &cache->data_[cache->size_];
+    end = cache->size_ + CACHE_RECORD_SIZE +
+          2 * (record[DEAL_SIZE + 1] | (record[DEAL_SIZE + 2] << 8));
+    if (end > (size_t)info.st_size)
+    {
+      break;
+    }
+    if (insertCachedDeal(cache, cache->size_) != 0)
+    {
+      return 2;
+    }
+    cache->size_ = end;
+  }
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Finds the record of a deal in the slots of the cache.
+///
+/// @param cache the cache, locked
+/// @param deal DEAL_SIZE card numbers
+///
+/// @return the offset of the record in the file, 0 if there is none
+//
+size_t lookupCachedDeal(DealCache* cache, unsigned char* deal)
+{
+  size_t slot = hashDeal(deal) & (cache->capacity_ - 1);
+  while (cache->slots_[slot] != 0)
+  {
+    if (memcmp(&cache->data_[cache->slots_[slot]], deal, DEAL_SIZE) == 0)
+    {
+      return cache->slots_[slot];
+    }
+    slot = (slot + 1) & (cache->capacity_ - 1);
+  }
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Adds the offset of a record to the slots of the cache. The slots are
+/// at most half full, they double before that.
+///
+/// @param cache the cache, locked
+/// @param offset where the record starts in the file
+///
+/// @return 0 if the record was added
+/// @return 2 if out of memory
+//
+int insertCachedDeal(DealCache* cache, size_t offset)
+{
+  size_t i;
+  size_t slot;
+  size_t *old_slots = cache->slots_;
+  size_t old_capacity = cache->capacity_;
+  if (2 * (cache->count_ + 1) > cache->capacity_)
+  {
+    cache->slots_ = (size_t*)calloc(2 * old_capacity, sizeof(size_t));
+    if (cache->slots_ == NULL)
+    {
+      cache->slots_ = old_slots;
+      return 2;
+    }
+    cache->capacity_ = 2 * old_capacity;
+    cache->count_ = 0;
+    for (i = 0; i < old_capacity; i++)
+    {
+      if (old_slots[i] != 0)
+      {
+        insertCachedDeal(cache, old_slots[i]);
+      }
+    }
+    free(old_slots);
+  }
+  slot = hashDeal(&cache->data_[offset]) & (cache->capacity_ - 1);
+  while (cache->slots_[slot] != 0)
+  {
+    slot = (slot + 1) & (cache->capacity_ - 1);
+  }
+  cache->slots_[slot] = offset;
+  cache->count_++;
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Hash of the order of the cards of a deal.
+///
+/// @param deal DEAL_SIZE card numbers
+///
+/// @return the hash
+//
+unsigned long long hashDeal(const unsigned char* deal)
+{
+  int i;
+  unsigned long long hash = 0;
+  for (i = 0; i < DEAL_SIZE; i++)
+  {
+    hash = mixHash(hash + deal[i] + 1);
+  }
+  return hash;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Checks whether a game is in the position its deal starts with, the only
+/// one the cache knows.
+///
+/// @param board the decks of the game
+/// @param card_instance array of cards in the double-linked list
+///
+/// @return 1 if no move was made, or all were taken back
+/// @return 0 if the game is in another position
+//
+int checkDealStart(Board* board, Card* card_instance)
+{
+  Board start;
+  Card cards[26];
+  memcpy(cards, card_instance, sizeof(cards));
+  setFirstPointers(&start, cards);
+  return start.hash_ == board->hash_;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Prints a move_var as the command the user would type for it.
+///
+/// @param move_var the number containing description of the wanted card
+//
+void printMoveCommand(int move_var)
+{
+  char command[LINE_SIZE];
+  formatMoveCommand(move_var, command);
+  fputs(command, stdout);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Writes a move_var as the command the user would type for it, with the
+/// newline.
+///
+/// @param move_var the number containing description of the wanted card
+/// @param command buffer of LINE_SIZE characters that gets the command
+///
+/// @return number of characters written
+//
+int formatMoveCommand(int move_var, char* command)
+{
+  static const char *value_names[] = {"", "A", "2", "3", "4", "5", "6", "7",
+                                      "8", "9", "10", "J", "Q", "K"};
+  int card_value = move_var % 100;
+  if (card_value > 13)
+  {
+    return sprintf(command, "move black %s to %d\n",
+                   value_names[card_value - 13], move_var / 100);
+  }
+  return sprintf(command, "move red %s to %d\n", value_names[card_value],
+                 move_var / 100);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Searches all positions reachable from the current one with several
+/// threads. Every thread has its own copy of the cards and a deque of
+/// positions still to be searched, threads without work steal from the
+/// others. The reached positions are shared in a PositionTable of a fixed
+/// size. The board is not changed.
+///
+/// @param board the decks of the game
+/// @param card_instance array of cards in the double-linked list
+/// @param solution filled with the winning moves, see freeSolution
+/// @param threads number of threads
+///
+/// @return 0 if the game can not be won
+/// @return 1 if the game can be won
+/// @return 2 if out of memory
+//
+int solveGameParallel(Board* board, Card* card_instance, Solution* solution,
+                      int threads)
+{
+  int i;
+  int started = 0;
+  int err_var;
+  Task root;
+  PathBlock *block;
+  ParallelSearch search;
+  unsigned char key[KEY_SIZE];
+  solution->moves_ = NULL;
+  solution->length_ = 0;
+  solution->capacity_ = 0;
+  solution->arena_ = NULL;
+  search.workers_ = (Worker*)calloc(threads, sizeof(Worker));
+  search.table_.buckets_ = ((size_t)1 << TABLE_BITS) / TABLE_WAYS;
+  search.table_.entries_ = (unsigned long long*)calloc(
+                             (size_t)1 << TABLE_BITS,
+                             sizeof(unsigned long long));
+  search.table_.keys_ = (unsigned char*)malloc(((size_t)1 << TABLE_BITS) *
+                                               KEY_SIZE);
+  search.table_.locks_ = (pthread_mutex_t*)malloc(TABLE_LOCKS *
+                                                  sizeof(pthread_mutex_t));
+  if ((search.workers_ == NULL) || (search.table_.entries_ == NULL) ||
+      (search.table_.keys_ == NULL) || (search.table_.locks_ == NULL))
+  {
+    free(search.workers_);
+    free(search.table_.entries_);
+    free(search.table_.keys_);
+    free(search.table_.locks_);
+    printf("[ERR] Out of memory\n");
+    return 2;
+  }
+  for (i = 0; i < TABLE_LOCKS; i++)
+  {
+    pthread_mutex_init(&search.table_.locks_[i], NULL);
+  }
+  search.count_ = threads;
+  search.solution_ = solution;
+  atomic_init(&search.pending_, 0);
+  atomic_init(&search.result_, 0);
+  pthread_mutex_init(&search.solution_lock_, NULL);
+  for (i = 0; i < threads; i++)
+  {
+    memcpy(search.workers_[i].card_instance_, card_instance,
+           26 * sizeof(Card));
+    search.workers_[i].search_ = &search;
+    search.workers_[i].id_ = i;
+    pthread_mutex_init(&search.workers_[i].lock_, NULL);
+  }
+  saveSnapshot(board, card_instance, &root.position_);
+  root.path_ = NULL;
+  root.depth_ = 0;
+  encodePosition(board, card_instance, key);
+  probePosition(&search.table_, key, canonicalHash(board), 0);
+  if (pushTask(&search.workers_[0], &root) == 2)
+  {
+    atomic_store(&search.result_, 2);
+  }
+  else
+  {
+    for (started = 0; started < threads; started++)
+    {
+      if (pthread_create(&search.workers_[started].thread_, NULL,
+                         parallelWorkerFunction,
+                         &search.workers_[started]) != 0)
+      {
+        break;
+      }
+    }
+    if (started == 0)
+    {
+      // no thread could be started, the calling thread does the work
+      parallelWorkerFunction(&search.workers_[0]);
+    }
+    for (i = 0; i < started; i++)
+    {
+      pthread_join(search.workers_[i].thread_, NULL);
+    }
+  }
+  for (i = 0; i < threads; i++)
+  {
+    while (search.workers_[i].blocks_ != NULL)
+    {
+      block = search.workers_[i].blocks_;
+      search.workers_[i].blocks_ = block->next_;
+      free(block);
+    }
+    free(search.workers_[i].tasks_);
+    pthread_mutex_destroy(&search.workers_[i].lock_);
+  }
+  for (i = 0; i < TABLE_LOCKS; i++)
+  {
+    pthread_mutex_destroy(&search.table_.locks_[i]);
+  }
+  free(search.table_.entries_);
+  free(search.table_.keys_);
+  free(search.table_.locks_);
+  pthread_mutex_destroy(&search.solution_lock_);
+  free(search.workers_);
+  err_var = atomic_load(&search.result_);
+  if (err_var == 2)
+  {
+    printf("[ERR] Out of memory\n");
+  }
+  return err_var;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Main loop of a solver thread. Takes tasks from its own deque, or steals
+/// them from the other threads, until all positions are searched or a win
+/// was found.
+///
+/// @param argument the Worker of this thread
+///
+/// @return NULL
+//
+void* parallelWorkerFunction(void* argument)
+{
+  Worker *worker = (Worker*)argument;
+  ParallelSearch *search = worker->search_;
+  Task task;
+  while ((atomic_load(&search->result_) == 0) &&
+         (atomic_load(&search->pending_) > 0))
+  {
+    if ((popTask(worker, &task) == 0) && (stealTask(worker, &task) == 0))
+    {
+      sched_yield();
+      continue;
+    }
+    if (expandTask(worker, &task) == 2)
+    {
+      atomic_store(&search->result_, 2);
+    }
+    atomic_fetch_sub(&search->pending_, 1);
+  }
+  return NULL;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Searches one position. If it is won the path to it becomes the solution,
+/// otherwise every position reachable with one move that probePosition
+/// says has to be searched is pushed to the deque of the worker. They are
+/// pushed in reverse order, so the first move is popped next. Nothing is
+/// pushed below MAX_SEARCH_DEPTH, which ends the search even if the table
+/// forgot positions.
+///
+/// @param worker the thread doing the search
+/// @param task the position
+///
+/// @return 0 if the position was searched
+/// @return 2 if out of memory
+//
+int expandTask(Worker* worker, Task* task)
+{
+  int i;
+  int count;
+  int extra;
+  int current_deck;
+  int moves[MAX_MOVES];
+  int rest[TABLEBASE_MOVES];
+  unsigned char key[KEY_SIZE];
+  Board *board = &worker->board_;
+  Card *card_instance = worker->card_instance_;
+  Card *wanted_card;
+  PathNode *node;
+  Task child;
+  Solution *solution = worker->search_->solution_;
+  restoreSnapshot(board, card_instance, &task->position_);
+  // the tablebase knows whether positions near the end can be won
+  extra = probeTablebase(board);
+  if (extra == 0)
+  {
+    return 0;
+  }
+  extra = (extra > 0) ? followTablebase(board, rest) : -1;
+  if ((checkForWin(board) == 1) || (extra >= 0))
+  {
+    extra = (extra > 0) ? extra : 0;
+    pthread_mutex_lock(&worker->search_->solution_lock_);
+    if (atomic_load(&worker->search_->result_) == 0)
+    {
+      solution->moves_ = (int*)malloc((task->depth_ + extra + 1) *
+                                      sizeof(int));
+      if (solution->moves_ == NULL)
+      {
+        pthread_mutex_unlock(&worker->search_->solution_lock_);
+        return 2;
+      }
+      solution->length_ = task->depth_ + extra;
+      solution->capacity_ = task->depth_ + extra + 1;
+      for (node = task->path_, i = task->depth_ - 1; node != NULL;
+           node = node->parent_, i--)
+      {
+        solution->moves_[i] = node->move_;
+      }
+      memcpy(&solution->moves_[task->depth_], rest, extra * sizeof(int));
+      atomic_store(&worker->search_->result_, 1);
+    }
+    pthread_mutex_unlock(&worker->search_->solution_lock_);
+    return 0;
+  }
+  if (task->depth_ == MAX_SEARCH_DEPTH)
+  {
+    return 0;
+  }
+  count = listCandidateMoves(board, moves);
+  for (i = count - 1; i >= 0; i--)
+  {
+    wanted_card = findCardFromMoveVar(moves[i], board);
+    current_deck = travelToTheTop(wanted_card);
+    moveCards(board, wanted_card, current_deck, moves[i] / 100);
+    encodePosition(board, card_instance, key);
+    if (probePosition(&worker->search_->table_, key, canonicalHash(board),
+                      task->depth_ + 1) == 1)
+    {
+      saveSnapshot(board, card_instance, &child.position_);
+      child.path_ = newPathNode(worker, moves[i], task->path_);
+      child.depth_ = task->depth_ + 1;
+      if ((child.path_ == NULL) || (pushTask(worker, &child) == 2))
+      {
+        return 2;
+      }
+    }
+    unmakeMove(board, wanted_card, current_deck);
+  }
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Adds a task at the end of the deque of a worker.
+///
+/// @param worker the owner of the deque
+/// @param task the task
+///
+/// @return 0 if the task was added
+/// @return 2 if out of memory
+//
+int pushTask(Worker* worker, Task* task)
+{
+  int err_var = 0;
+  Task *tasks;
+  pthread_mutex_lock(&worker->lock_);
+  if ((worker->first_ > 0) && (worker->count_ == worker->capacity_))
+  {
+    memmove(worker->tasks_, &worker->tasks_[worker->first_],
+            (worker->count_ - worker->first_) * sizeof(Task));
+    worker->count_ -= worker->first_;
+    worker->first_ = 0;
+  }
+  if (worker->count_ == worker->capacity_)
+  {
+    tasks = (Task*)realloc(worker->tasks_,
+                           2 * (worker->capacity_ + 32) * sizeof(Task));
+    if (tasks == NULL)
+    {
+      err_var = 2;
+    }
+    else
+    {
+      worker->tasks_ = tasks;
+      worker->capacity_ = 2 * (worker->capacity_ + 32);
+    }
+  }
+  if (err_var == 0)
+  {
+    worker->tasks_[worker->count_++] = *task;
+    atomic_fetch_add(&worker->search_->pending_, 1);
+  }
+  pthread_mutex_unlock(&worker->lock_);
+  return err_var;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Takes the newest task from the end of the own deque.
+///
+/// @param worker the owner of the deque
+/// @param task where the task is stored
+///
+/// @return 1 if a task was taken
+/// @return 0 if the deque is empty
+//
+int popTask(Worker* worker, Task* task)
+{
+  int found = 0;
+  pthread_mutex_lock(&worker->lock_);
+  if (worker->count_ > worker->first_)
+  {
+    *task = worker->tasks_[--worker->count_];
+    found = 1;
+  }
+  if (worker->count_ == worker->first_)
+  {
+    worker->first_ = 0;
+    worker->count_ = 0;
+  }
+  pthread_mutex_unlock(&worker->lock_);
+  return found;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Takes the oldest task from the front of the deque of another worker.
+///
+/// @param worker the worker looking for work
+/// @param task where the task is stored
+///
+/// @return 1 if a task was stolen
+/// @return 0 if all other deques are empty
+//
+int stealTask(Worker* worker, Task* task)
+{
+  int i;
+  int found = 0;
+  Worker *victim;
+  for (i = 1; (i < worker->search_->count_) && (found == 0); i++)
+  {
+    victim = &worker->search_->workers_[(worker->id_ + i) %
+                                         worker->search_->count_];
+    pthread_mutex_lock(&victim->lock_);
+    if (victim->count_ > victim->first_)
+    {
+      *task = victim->tasks_[victim->first_++];
+      found = 1;
+    }
+    pthread_mutex_unlock(&victim->lock_);
+  }
+  return found;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Looks a position up in the shared table and records it there, under the
+/// lock of its bucket. A position already reached at the same or a smaller
+/// depth does not have to be searched again. One reached deeper is searched
+/// again and its depth is lowered. A new position takes an empty entry of
+/// its bucket, or the entry of the deepest position there if that is deeper
+/// than the new one, otherwise it is searched without being recorded. The
+/// key is compared whenever the hash matches, so two positions are never
+/// taken as one.
+///
+/// @param table the shared table
+/// @param key the key of the position, see encodePosition
+/// @param hash the hash of the position, see canonicalHash
+/// @param depth number of moves made to reach the position
+///
+/// @return 1 if the position has to be searched
+/// @return 0 if it does not
+//
+int probePosition(PositionTable* table, unsigned char* key,
+                  unsigned long long hash, int depth)
+{
+  int i;
+  int victim = -1;
+  int err_var = 1;
+  unsigned long long victim_depth = 0;
+  unsigned long long stored;
+  unsigned long long tag = hash & ~TABLE_DEPTH_MASK;
+  size_t index = (size_t)(hash & (table->buckets_ - 1));
+  size_t first = index * TABLE_WAYS;
+  unsigned long long *bucket = &table->entries_[first];
+  pthread_mutex_lock(&table->locks_[index % TABLE_LOCKS]);
+  for (i = 0; i < TABLE_WAYS; i++)
+  {
+    if (bucket[i] == 0)
+    {
+      // entries are never emptied, so the ones after this are empty too
+      victim = i;
+      victim_depth = TABLE_DEPTH_MASK + 1;
+      break;
+    }
+    stored = bucket[i] & TABLE_DEPTH_MASK;
+    if (((bucket[i] & ~TABLE_DEPTH_MASK) == tag) &&
+        (memcmp(&table->keys_[(first + i) * KEY_SIZE], key, KEY_SIZE) == 0))
+    {
+      victim = i;
+      victim_depth = TABLE_DEPTH_MASK + 1;
+      err_var = (stored <= (unsigned long long)(depth + 1)) ? 0 : 1;
+      break;
+    }
+    if (stored > victim_depth)
+    {
+      victim = i;
+      victim_depth = stored;
+    }
+  }
+  if ((err_var == 1) && (victim_depth > (unsigned long long)(depth + 1)))
+  {
+    bucket[victim] = tag | (unsigned long long)(depth + 1);
+    memcpy(&table->keys_[(first + victim) * KEY_SIZE], key, KEY_SIZE);
+  }
+  pthread_mutex_unlock(&table->locks_[index % TABLE_LOCKS]);
+  return err_var;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Gets a new path node from the blocks of a worker.
+///
+/// @param worker the thread that needs the node
+/// @param move_var the move
+/// @param parent the path before the move
+///
+/// @return the node
+/// @return NULL if out of memory
+//
+PathNode* newPathNode(Worker* worker, int move_var, PathNode* parent)
+{
+  PathBlock *block = worker->blocks_;
+  PathNode *node;
+  if ((block == NULL) || (block->used_ == PATH_BLOCK_SIZE))
+  {
+    block = (PathBlock*)malloc(sizeof(PathBlock));
+    if (block == NULL)
+    {
+      return NULL;
+    }
+    block->used_ = 0;
+    block->next_ = worker->blocks_;
+    worker->blocks_ = block;
+  }
+  node = &block->nodes_[block->used_++];
+  node->move_ = move_var;
+  node->parent_ = parent;
+  return node;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Benchmarks entireInputFromFile, setFirstPointers, checkUserInput,
+/// checkForValidMove, checkMoveForDeposit, travelToTheTop,
+/// travelToTheBottom and mainPrintFunction over a corpus of generated deals
+/// (BENCH_DEALS or the given number). Every function is first run in a
+/// loop for BENCH_TIME ns to get ns/op and allocations/op, then
+/// BENCH_SAMPLES single calls are timed for the latency percentiles. The
+/// cost of calling an empty function, and of reading the clock for the
+/// percentiles, is taken off. The board output goes to /dev/null while
+/// mainPrintFunction is timed.
+///
+/// @param count number of arguments
+/// @param args maybe the number of deals
+///
+/// @return 0 if the benchmarks were run
+/// @return 1 if the number of deals is invalid
+/// @return 2 if out of memory
+//
+int mainBenchFunction(int count, char** args)
+{
+  int i;
+  int deals = BENCH_DEALS;
+  int output;
+  int discard;
+  long *samples;
+  BenchCorpus corpus;
+  Benchmark nothing = {.name_ = "", .function_ = benchNothing};
+  Benchmark benches[] = {
+    {.name_ = "entireInputFromFile", .function_ = benchEntireInputFromFile},
+    {.name_ = "setFirstPointers", .function_ = benchSetFirstPointers},
+    {.name_ = "checkUserInput", .function_ = benchCheckUserInput},
+    {.name_ = "checkForValidMove", .function_ = benchCheckForValidMove},
+    {.name_ = "checkMoveForDeposit", .function_ = benchCheckMoveForDeposit},
+    {.name_ = "travelToTheTop", .function_ = benchTravelToTheTop},
+    {.name_ = "travelToTheBottom", .function_ = benchTravelToTheBottom},
+    {.name_ = "mainPrintFunction", .function_ = benchMainPrintFunction}};
+  if (count > 0)
+  {
+    deals = atoi(args[0]);
+  }
+  if ((count > 1) || (deals < 1) || (deals > 1000000))
+  {
+    printf("[ERR] Usage: --bench [deals]\n");
+    return 1;
+  }
+  samples = (long*)malloc(BENCH_SAMPLES * sizeof(long));
+  if ((samples == NULL) || (buildBenchCorpus(&corpus, deals) == 2))
+  {
+    free(samples);
+    printf("[ERR] Out of memory\n");
+    return 2;
+  }
+  benches[0].operations_ = corpus.deals_;
+  benches[1].operations_ = corpus.deals_;
+  benches[2].operations_ = corpus.script_lines_;
+  benches[3].operations_ = corpus.tableau_count_;
+  benches[4].operations_ = corpus.deposit_count_;
+  benches[5].operations_ = corpus.positions_ * 26;
+  benches[6].operations_ = corpus.positions_ * 7;
+  benches[7].operations_ = corpus.positions_;
+  nothing.operations_ = corpus.positions_;
+  runBenchmark(&corpus, &nothing, samples);
+  printf("[INFO] %d deals, %d positions, call %.1f ns, clock %ld ns\n",
+         corpus.deals_, corpus.positions_, nothing.ns_per_op_,
+         nothing.latency_[0]);
+  printf("%-20s %10s %10s %8s %8s %8s %8s\n", "function", "ns/op",
+         "allocs/op", "p50", "p90", "p99", "max");
+  for (i = 0; i < 8; i++)
+  {
+    fflush(stdout);
+    output = dup(STDOUT_FILENO);
+    discard = open("/dev/null", O_WRONLY);
+    if ((i == 7) && (output >= 0) && (discard >= 0))
+    {
+      dup2(discard, STDOUT_FILENO);
+    }
+    runBenchmark(&corpus, &benches[i], samples);
+    fflush(stdout);
+    if (output >= 0)
+    {
+      dup2(output, STDOUT_FILENO);
+      close(output);
+    }
+    if (discard >= 0)
+    {
+      close(discard);
+    }
+    benches[i].ns_per_op_ -= nothing.ns_per_op_;
+    printf("%-20s %10.1f %10.2f %8ld %8ld %8ld %8ld\n", benches[i].name_,
+           (benches[i].ns_per_op_ > 0) ? benches[i].ns_per_op_ : 0.0,
+           benches[i].allocations_per_op_,
+           benches[i].latency_[0] - nothing.latency_[0],
+           benches[i].latency_[1] - nothing.latency_[0],
+           benches[i].latency_[2] - nothing.latency_[0],
+           benches[i].latency_[3] - nothing.latency_[0]);
+  }
+  freeBenchCorpus(&corpus);
+  free(samples);
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Generates the deals of the corpus and writes them as text and as a
+/// command script. From every deal BENCH_CHECKPOINTS positions are taken,
+/// with BENCH_STEPS legal moves played between two of them. The moves are
+/// also written to the script, followed by a help, an invalid and an undo
+/// command at every position.
+///
+/// @param corpus the corpus
+/// @param deals number of deals
+///
+/// @return 0 if the corpus was built
+/// @return 2 if out of memory
+//
+int buildBenchCorpus(BenchCorpus* corpus, int deals)
+{
+  static const char *extra_lines[] = {"help\n", "move red 11 to 3\n",
+                                      "undo\n"};
+  int i;
+  int step;
+  int count;
+  int moves[MAX_MOVES];
+  char command[LINE_SIZE];
+  Card card_instance[26];
+  Board board;
+  Card *wanted_card;
+  FILE *text;
+  FILE *script;
+  memset(corpus, 0, sizeof(BenchCorpus));
+  text = open_memstream(&corpus->text_, &corpus->text_length_);
+  script = open_memstream(&corpus->script_, &corpus->script_length_);
+  corpus->deals_ = deals;
+  corpus->deal_cards_ = (Card(*)[26])malloc(deals * sizeof(Card[26]));
+  corpus->cards_ = (Card(*)[26])malloc(deals * BENCH_CHECKPOINTS *
+                                       sizeof(Card[26]));
+  corpus->boards_ = (Board*)malloc(deals * BENCH_CHECKPOINTS *
+                                   sizeof(Board));
+  corpus->tableau_moves_ = (int*)malloc(deals * BENCH_CHECKPOINTS * 26 * 4 *
+                                        sizeof(int));
+  corpus->deposit_moves_ = (int*)malloc(deals * BENCH_CHECKPOINTS * 26 * 2 *
+                                        sizeof(int));
+  corpus->text_offsets_ = (size_t*)malloc((deals + 1) * sizeof(size_t));
+  corpus->text_files_ = (FILE**)calloc(deals, sizeof(FILE*));
+  if ((text == NULL) || (script == NULL) || (corpus->deal_cards_ == NULL) ||
+      (corpus->cards_ == NULL) || (corpus->boards_ == NULL) ||
+      (corpus->tableau_moves_ == NULL) || (corpus->deposit_moves_ == NULL) ||
+      (corpus->text_offsets_ == NULL) || (corpus->text_files_ == NULL))
+  {
+    if (text != NULL)
+    {
+      fclose(text);
+    }
+    if (script != NULL)
+    {
+      fclose(script);
+    }
+    freeBenchCorpus(corpus);
+    return 2;
+  }
+  for (i = 0; i < deals; i++)
+  {
+    generateDeal((unsigned long long)i, corpus->deal_cards_[i]);
+    fflush(text);
+    corpus->text_offsets_[i] = corpus->text_length_;
+    printDeal(text, corpus->deal_cards_[i]);
+    fputc('\n', text);
+    memcpy(card_instance, corpus->deal_cards_[i], sizeof(card_instance));
+    setFirstPointers(&board, card_instance);
+    for (step = 0; step < BENCH_CHECKPOINTS * BENCH_STEPS; step++)
+    {
+      if (step % BENCH_STEPS == 0)
+      {
+        addBenchPosition(corpus, &board, card_instance);
+        for (count = 0; count < 3; count++)
+        {
+          fputs(extra_lines[count], script);
+        }
+        corpus->script_lines_ += 3;
+      }
+      count = generateMoves(&board, moves);
+      if (count == 0)
+      {
+        break;
+      }
+      wanted_card = findCardFromMoveVar(moves[(i + step) % count], &board);
+      makeMove(&board, wanted_card, wanted_card->deck_,
+               moves[(i + step) % count] / 100);
+      formatMoveCommand(moves[(i + step) % count], command);
+      fputs(command, script);
+      corpus->script_lines_++;
+    }
+  }
+  fclose(text);
+  fclose(script);
+  corpus->text_offsets_[deals] = corpus->text_length_;
+  corpus->session_.input_ = fmemopen(corpus->script_,
+                                     corpus->script_length_, "r");
+  corpus->session_.quiet_ = 1;
+  corpus->session_.threads_ = 1;
+  if (corpus->session_.input_ == NULL)
+  {
+    freeBenchCorpus(corpus);
+    return 2;
+  }
+  for (i = 0; i < deals; i++)
+  {
+    // without the empty line that separates the deals
+    corpus->text_files_[i] = fmemopen(&corpus->text_[
+                                      corpus->text_offsets_[i]],
+                                      corpus->text_offsets_[i + 1] -
+                                      corpus->text_offsets_[i] - 1, "r");
+    if (corpus->text_files_[i] == NULL)
+    {
+      freeBenchCorpus(corpus);
+      return 2;
+    }
+  }
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Copies a position into the corpus and lists the moves checkMove would
+/// hand to checkForValidMove and checkMoveForDeposit from it.
+///
+/// @param corpus the corpus
+/// @param board the decks of the position
+/// @param card_instance array of cards in the double-linked list
+//
+void addBenchPosition(BenchCorpus* corpus, Board* board, Card* card_instance)
+{
+  int i;
+  int desired_deck;
+  int position = corpus->positions_++;
+  Snapshot snapshot;
+  Card *wanted_card;
+  memcpy(corpus->cards_[position], card_instance, sizeof(Card[26]));
+  saveSnapshot(board, card_instance, &snapshot);
+  restoreSnapshot(&corpus->boards_[position], corpus->cards_[position],
+                  &snapshot);
+  for (i = 0; i < 26; i++)
+  {
+    wanted_card = board->index_[i];
+    if ((wanted_card->deck_ > 4) ||
+        ((wanted_card->deck_ == 0) && (wanted_card->next_ != NULL)))
+    {
+      continue;
+    }
+    for (desired_deck = 1; desired_deck < 7; desired_deck++)
+    {
+      if (desired_deck == wanted_card->deck_)
+      {
+        continue;
+      }
+      if (desired_deck < 5)
+      {
+        corpus->tableau_moves_[corpus->tableau_count_++] =
+          position * 1000 + desired_deck * 100 + i + 1;
+      }
+      else
+      {
+        corpus->deposit_moves_[corpus->deposit_count_++] =
+          position * 1000 + desired_deck * 100 + i + 1;
+      }
+    }
+  }
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Frees everything buildBenchCorpus allocated.
+///
+/// @param corpus the corpus
+//
+void freeBenchCorpus(BenchCorpus* corpus)
+{
+  int i;
+  for (i = 0; (corpus->text_files_ != NULL) && (i < corpus->deals_); i++)
+  {
+    if (corpus->text_files_[i] != NULL)
+    {
+      fclose(corpus->text_files_[i]);
+    }
+  }
+  free(corpus->text_files_);
+  free(corpus->text_offsets_);
+  if (corpus->session_.input_ != NULL)
+  {
+    fclose(corpus->session_.input_);
+  }
+  free(corpus->text_);
+  free(corpus->script_);
+  free(corpus->deal_cards_);
+  free(corpus->cards_);
+  free(corpus->boards_);
+  free(corpus->tableau_moves_);
+  free(corpus->deposit_moves_);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Runs one benchmark, going through the elements of the corpus in order
+/// and starting over at the end.
+///
+/// @param corpus the corpus
+/// @param bench the function, gets the results
+/// @param samples room for BENCH_SAMPLES latencies
+//
+void runBenchmark(BenchCorpus* corpus, Benchmark* bench, long* samples)
+{
+  long i;
+  long index = 0;
+  long done = 0;
+  volatile long result = 0;
+  long allocations;
+  long long start;
+  long long now;
+  allocations = atomic_load(&allocation_count) +
+                atomic_load(&reallocation_count);
+  start = readClock();
+  do
+  {
+    for (i = 0; i < bench->operations_; i++)
+    {
+      result += bench->function_(corpus, i);
+    }
+    done += bench->operations_;
+    now = readClock();
+  } while (now - start < BENCH_TIME);
+  bench->ns_per_op_ = (double)(now - start) / (double)done;
+  bench->allocations_per_op_ = (double)(atomic_load(&allocation_count) +
+                                        atomic_load(&reallocation_count) -
+                                        allocations) / (double)done;
+  for (i = 0; i < BENCH_SAMPLES; i++)
+  {
+    start = readClock();
+    result += bench->function_(corpus, index);
+    samples[i] = (long)(readClock() - start);
+    if (++index == bench->operations_)
+    {
+      index = 0;
+    }
+  }
+  qsort(samples, BENCH_SAMPLES, sizeof(long), compareLatency);
+  bench->latency_[0] = samples[BENCH_SAMPLES / 2];
+  bench->latency_[1] = samples[BENCH_SAMPLES * 9 / 10];
+  bench->latency_[2] = samples[BENCH_SAMPLES * 99 / 100];
+  bench->latency_[3] = samples[BENCH_SAMPLES - 1];
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Reads the monotonic clock.
+///
+/// @return the time in ns
+//
+long long readClock(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Orders latencies for qsort.
+///
+/// @param first the first latency
+/// @param second the second latency
+///
+/// @return less than, equal to or greater than 0
+//
+int compareLatency(const void* first, const void* second)
+{
+  long difference = *(const long*)first - *(const long*)second;
+  return (difference > 0) - (difference < 0);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Does nothing, measures the cost of the benchmark loop itself.
+///
+/// @param corpus the corpus
+/// @param index the element
+///
+/// @return index
+//
+long benchNothing(BenchCorpus* corpus, long index)
+{
+  (void)corpus;
+  return index;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Reads one deal of the text from its own stream, as entireInputFromFile
+/// reads a stream to its end.
+///
+/// @param corpus the corpus
+/// @param index the deal
+///
+/// @return what entireInputFromFile returns
+//
+long benchEntireInputFromFile(BenchCorpus* corpus, long index)
+{
+  rewind(corpus->text_files_[index]);
+  return entireInputFromFile(corpus->text_files_[index],
+                             corpus->scratch_cards_);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Deals the cards of one deal.
+///
+/// @param corpus the corpus
+/// @param index the deal
+///
+/// @return 0
+//
+long benchSetFirstPointers(BenchCorpus* corpus, long index)
+{
+  setFirstPointers(&corpus->scratch_board_, corpus->deal_cards_[index]);
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Reads the next command of the script, the first one again at index 0.
+///
+/// @param corpus the corpus
+/// @param index the line
+///
+/// @return what checkUserInput returns
+//
+long benchCheckUserInput(BenchCorpus* corpus, long index)
+{
+  if (index == 0)
+  {
+    rewind(corpus->session_.input_);
+  }
+  return checkUserInput(&corpus->session_);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Checks one move to deck 1 to 4.
+///
+/// @param corpus the corpus
+/// @param index the move
+///
+/// @return what checkForValidMove returns
+//
+long benchCheckForValidMove(BenchCorpus* corpus, long index)
+{
+  Board *board = &corpus->boards_[corpus->tableau_moves_[index] / 1000];
+  int move_var = corpus->tableau_moves_[index] % 1000;
+  return checkForValidMove(board, findCardFromMoveVar(move_var, board),
+                           move_var / 100);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Checks one move to deck 5 or 6.
+///
+/// @param corpus the corpus
+/// @param index the move
+///
+/// @return what checkMoveForDeposit returns
+//
+long benchCheckMoveForDeposit(BenchCorpus* corpus, long index)
+{
+  Board *board = &corpus->boards_[corpus->deposit_moves_[index] / 1000];
+  int move_var = corpus->deposit_moves_[index] % 1000;
+  return checkMoveForDeposit(board, findCardFromMoveVar(move_var, board),
+                             move_var / 100);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Finds the deck of one card.
+///
+/// @param corpus the corpus
+/// @param index position * 26 + card
+///
+/// @return the deck
+//
+long benchTravelToTheTop(BenchCorpus* corpus, long index)
+{
+  return travelToTheTop(&corpus->cards_[index / 26][index % 26]);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Finds the last card of one deck.
+///
+/// @param corpus the corpus
+/// @param index position * 7 + deck
+///
+/// @return 1 if the deck has cards, 0 if not
+//
+long benchTravelToTheBottom(BenchCorpus* corpus, long index)
+{
+  return travelToTheBottom(&corpus->boards_[index / 7], index % 7) != NULL;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Prints one position.
+///
+/// @param corpus the corpus
+/// @param index the position
+///
+/// @return what mainPrintFunction returns
+//
+long benchMainPrintFunction(BenchCorpus* corpus, long index)
+{
+  return mainPrintFunction(corpus->boards_[index].deck_);
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Clears the stats and reads the allocation counters.
+///
+/// @param stats the stats
+/// @param json 1 if they are printed as JSON, 0 for text
+//
+void startStats(Stats* stats, int json)
+{
+  memset(stats, 0, sizeof(Stats));
+  stats->json_ = json;
+  stats->allocations_ = atomic_load(&allocation_count);
+  stats->reallocations_ = atomic_load(&reallocation_count);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Reads the clock at the start of a phase, if there are stats.
+///
+/// @param stats the stats or NULL
+///
+/// @return the time in ns, 0 without stats
+//
+long long startPhase(Stats* stats)
+{
+  return (stats == NULL) ? 0 : readClock();
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Adds the time since start to the histogram of a phase, if there are
+/// stats.
+///
+/// @param stats the stats or NULL
+/// @param phase STATS_PARSE, STATS_VALIDATE, STATS_APPLY or STATS_RENDER
+/// @param start what startPhase returned
+//
+void endPhase(Stats* stats, int phase, long long start)
+{
+  long long elapsed;
+  int bucket = 0;
+  if (stats == NULL)
+  {
+    return;
+  }
+  elapsed = readClock() - start;
+  stats->total_ns_[phase] += elapsed;
+  while ((elapsed > 1) && (bucket < STATS_BUCKETS - 1))
+  {
+    elapsed >>= 1;
+    bucket++;
+  }
+  stats->histogram_[phase][bucket]++;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Prints the stats, as text lines starting with "[STATS]" or as one JSON
+/// object.
+///
+/// @param stats the stats
+/// @param output where they are printed
+//
+void printStats(Stats* stats, FILE* output)
+{
+  static const char *rule_names[] = {"stock-covered", "from-deposit",
+                                     "to-stock", "same-deck",
+                                     "deposit-covered", "deposit-ace",
+                                     "deposit-sequence", "invalid-run",
+                                     "tableau-king", "tableau-sequence",
+                                     "out-of-range"};
+  int i;
+  long rejected = 0;
+  long allocations = atomic_load(&allocation_count) - stats->allocations_;
+  long reallocations = atomic_load(&reallocation_count) -
+                       stats->reallocations_;
+  for (i = 0; i < MOVE_RULES; i++)
+  {
+    rejected += stats->rejected_[i];
+  }
+  if (stats->json_ == 0)
+  {
+    fprintf(output, "[STATS] valid moves %ld, invalid moves %ld, invalid "
+            "commands %ld, nothing to undo or redo %ld\n",
+            stats->valid_moves_, rejected, stats->invalid_commands_,
+            stats->nothing_to_undo_);
+    fprintf(output, "[STATS] rejected by");
+    for (i = 0; i < MOVE_RULES; i++)
+    {
+      fprintf(output, "%s %s %ld", (i == 0) ? "" : ",", rule_names[i],
+              stats->rejected_[i]);
+    }
+    fprintf(output, "\n");
+  }
+  else
+  {
+    fprintf(output, "{\"moves\": {\"valid\": %ld, \"invalid\": %ld, "
+            "\"rejected\": {", stats->valid_moves_, rejected);
+    for (i = 0; i < MOVE_RULES; i++)
+    {
+      fprintf(output, "%s\"%s\": %ld", (i == 0) ? "" : ", ", rule_names[i],
+              stats->rejected_[i]);
+    }
+    fprintf(output, "}}, \"invalid_commands\": %ld, \"nothing_to_undo\": "
+            "%ld, \"phases\": {", stats->invalid_commands_,
+            stats->nothing_to_undo_);
+  }
+  for (i = 0; i < STATS_PHASES; i++)
+  {
+    printPhaseStats(stats, i, output);
+  }
+  if (stats->json_ == 0)
+  {
+    fprintf(output, "[STATS] malloc %ld, realloc %ld\n", allocations,
+            reallocations);
+  }
+  else
+  {
+    fprintf(output, "}, \"malloc\": %ld, \"realloc\": %ld}\n", allocations,
+            reallocations);
+  }
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Prints the latency of one phase: how often it ran, the mean and the
+/// histogram buckets that are not empty, as [from, to) ns: count.
+///
+/// @param stats the stats
+/// @param phase the phase
+/// @param output where it is printed
+//
+void printPhaseStats(Stats* stats, int phase, FILE* output)
+{
+  static const char *phase_names[] = {"parse", "validate", "apply",
+                                      "render"};
+  int i;
+  int first = 1;
+  long count = 0;
+  for (i = 0; i < STATS_BUCKETS; i++)
+  {
+    count += stats->histogram_[phase][i];
+  }
+  if (stats->json_ == 0)
+  {
+    fprintf(output, "[STATS] %s count %ld, mean %lld ns", phase_names[phase],
+            count, (count == 0) ? 0 : stats->total_ns_[phase] / count);
+  }
+  else
+  {
+    fprintf(output, "%s\"%s\": {\"count\": %ld, \"total_ns\": %lld, "
+            "\"histogram\": [", (phase == 0) ? "" : ", ", phase_names[phase],
+            count, stats->total_ns_[phase]);
+  }
+  for (i = 0; i < STATS_BUCKETS; i++)
+  {
+    if (stats->histogram_[phase][i] == 0)
+    {
+      continue;
+    }
+    if (stats->json_ == 0)
+    {
+      fprintf(output, ", [%llu, %llu) %ld", (i == 0) ? 0 : 1ULL << i,
+              1ULL << (i + 1), stats->histogram_[phase][i]);
+    }
+    else
+    {
+      fprintf(output, "%s[%llu, %llu, %ld]", (first == 1) ? "" : ", ",
+              (i == 0) ? 0 : 1ULL << i, 1ULL << (i + 1),
+              stats->histogram_[phase][i]);
+    }
+    first = 0;
+  }
+  fprintf(output, (stats->json_ == 0) ? "\n" : "]}");
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Hosts games on a Unix domain socket, one game per connection, all in one
+/// thread on an epoll event loop. A player first sends a deal, either
+/// "deal <number>" for a generated deal or the 26 lines of a deal file, and
+/// gets the board. Then every line is a command as in the game, the reply is
+/// what the game prints, ending with "esp> ". The connection is closed after
+/// "exit" or when the game is won. The solve command is not served, it
+/// would hold up all other games. The server runs until it is killed.
+///
+/// @param socket_path where the socket is made, an old socket there is
+/// removed
+///
+/// @return 2 if out of memory
+/// @return 3 if the socket can not be made
+//
+int mainServerFunction(char* socket_path)
+{
+  Server server = {-1, -1, 1, 0};
+  struct sockaddr_un address;
+  struct epoll_event events[SERVER_EVENTS];
+  struct epoll_event event;
+  struct rlimit limit;
+  struct stat status;
+  int count;
+  int i;
+  if (strlen(socket_path) >= sizeof(address.sun_path))
+  {
+    printf("[ERR] Socket path too long!\n");
+    return 3;
+  }
+  if ((getrlimit(RLIMIT_NOFILE, &limit) == 0) &&
+      (limit.rlim_cur < limit.rlim_max))
+  {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+  if ((stat(socket_path, &status) == 0) && (S_ISSOCK(status.st_mode)))
+  {
+    unlink(socket_path);
+  }
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, socket_path);
+  server.listener_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK |
+                            SOCK_CLOEXEC, 0);
+  server.epoll_ = epoll_create1(EPOLL_CLOEXEC);
+  event.events = EPOLLIN;
+  event.data.ptr = NULL;
+  if ((server.listener_ < 0) || (server.epoll_ < 0) ||
+      (bind(server.listener_, (struct sockaddr*)&address,
+            sizeof(address)) != 0) ||
+      (listen(server.listener_, SOMAXCONN) != 0) ||
+      (epoll_ctl(server.epoll_, EPOLL_CTL_ADD, server.listener_,
+                 &event) != 0))
+  {
+    printf("[ERR] Can not listen on %s!\n", socket_path);
+    if (server.listener_ >= 0)
+    {
+      close(server.listener_);
+    }
+    if (server.epoll_ >= 0)
+    {
+      close(server.epoll_);
+    }
+    return 3;
+  }
+  printf("[INFO] Serving games on %s\n", socket_path);
+  fflush(stdout);
+  while (1)
+  {
+    count = epoll_wait(server.epoll_, events, SERVER_EVENTS, -1);
+    for (i = 0; i < count; i++)
+    {
+      if (events[i].data.ptr == NULL)
+      {
+        acceptConnections(&server);
+      }
+      else
+      {
+        serveConnection(&server, (Connection*)events[i].data.ptr,
+                        events[i].events);
+      }
+    }
+  }
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Accepts all waiting connections. When no more files can be opened the
+/// listening socket is not watched until a connection is closed, a player
+/// that can not get memory is turned away.
+///
+/// @param server the event loop
+//
+void acceptConnections(Server* server)
+{
+  struct epoll_event event;
+  Connection *connection;
+  int new_socket;
+  while (1)
+  {
+    new_socket = accept4(server->listener_, NULL, NULL,
+                         SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (new_socket < 0)
+    {
+      if ((errno == EMFILE) || (errno == ENFILE))
+      {
+        epoll_ctl(server->epoll_, EPOLL_CTL_DEL, server->listener_, NULL);
+        server->accepting_ = 0;
+      }
+      return;
+    }
+    connection = (Connection*)malloc(sizeof(Connection));
+    if (connection != NULL)
+    {
+      memset(connection, 0, sizeof(Connection));
+      connection->game_ = newGame();
+    }
+    event.events = EPOLLIN;
+    event.data.ptr = connection;
+    if ((connection == NULL) || (connection->game_ == NULL) ||
+        (epoll_ctl(server->epoll_, EPOLL_CTL_ADD, new_socket, &event) != 0))
+    {
+      if (connection != NULL)
+      {
+        freeGame(connection->game_);
+        free(connection);
+      }
+      close(new_socket);
+      continue;
+    }
+    connection->socket_ = new_socket;
+    connection->events_ = EPOLLIN;
+    server->connections_++;
+  }
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Sends what is left of the last reply, reads what the player sent and
+/// answers the lines one by one. While a reply can not be sent completely
+/// nothing is read, so a player that does not read can not make the server
+/// buffer more than one reply.
+///
+/// @param server the event loop
+/// @param connection the player
+/// @param events what epoll reported for the socket
+//
+void serveConnection(Server* server, Connection* connection,
+                     unsigned int events)
+{
+  struct epoll_event event;
+  char line[LINE_SIZE];
+  ssize_t length;
+  if (sendReply(connection) != 0)
+  {
+    closeConnection(server, connection);
+    return;
+  }
+  if ((connection->reply_length_ == 0) && (connection->closing_ == 0) &&
+      ((events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0))
+  {
+    length = recv(connection->socket_,
+                  &connection->input_[connection->input_length_],
+                  LINE_SIZE - 1 - connection->input_length_, 0);
+    if ((length == 0) || ((length < 0) && (errno != EAGAIN) &&
+                          (errno != EINTR)))
+    {
+      closeConnection(server, connection);
+      return;
+    }
+    if (length > 0)
+    {
+      connection->input_length_ += length;
+    }
+  }
+  while ((connection->reply_length_ == 0) && (connection->closing_ == 0) &&
+         (takeLine(connection, line) == 1))
+  {
+    if (connection->cards_ < 26)
+    {
+      serveDealLine(connection, line);
+    }
+    else
+    {
+      serveCommand(connection, line);
+    }
+    if (sendReply(connection) != 0)
+    {
+      closeConnection(server, connection);
+      return;
+    }
+  }
+  if ((connection->closing_ == 1) && (connection->reply_length_ == 0))
+  {
+    closeConnection(server, connection);
+    return;
+  }
+  event.events = (connection->reply_length_ == 0) ? EPOLLIN : EPOLLOUT;
+  if (event.events != connection->events_)
+  {
+    event.data.ptr = connection;
+    epoll_ctl(server->epoll_, EPOLL_CTL_MOD, connection->socket_, &event);
+    connection->events_ = event.events;
+  }
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Closes a connection and frees its game. If the server stopped accepting
+/// because it ran out of files, it accepts again.
+///
+/// @param server the event loop
+/// @param connection the player
+//
+void closeConnection(Server* server, Connection* connection)
+{
+  struct epoll_event event;
+  close(connection->socket_);
+  freeGame(connection->game_);
+  free(connection);
+  server->connections_--;
+  if (server->accepting_ == 0)
+  {
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    if (epoll_ctl(server->epoll_, EPOLL_CTL_ADD, server->listener_,
+                  &event) == 0)
+    {
+      server->accepting_ = 1;
+    }
+  }
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Takes the next complete line out of the input of a connection. If the
+/// input is full without a newline, that much is the line and the rest of
+/// it up to the newline is skipped, as fgets with LINE_SIZE would do.
+///
+/// @param connection the player
+/// @param line gets the line with its newline, 0 terminated
+///
+/// @return 1 if a line was taken
+/// @return 0 if there is no complete line yet
+//
+int takeLine(Connection* connection, char* line)
+{
+  char *end;
+  int length;
+  while (1)
+  {
+    end = (char*)memchr(connection->input_, '\n',
+                        connection->input_length_);
+    if (end != NULL)
+    {
+      length = end - connection->input_ + 1;
+    }
+    else if (connection->input_length_ == LINE_SIZE - 1)
+    {
+      length = LINE_SIZE - 1;
+    }
+    else
+    {
+      if (connection->skipping_ == 1)
+      {
+        connection->input_length_ = 0;
+      }
+      return 0;
+    }
+    memcpy(line, connection->input_, length);
+    line[length] = '\0';
+    connection->input_length_ -= length;
+    memmove(connection->input_, &connection->input_[length],
+            connection->input_length_);
+    if (connection->skipping_ == 1)
+    {
+      connection->skipping_ = (end == NULL);
+      continue;
+    }
+    connection->skipping_ = (end == NULL);
+    return 1;
+  }
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Takes a line of the deal. The first line that is not empty may be
+/// "deal <number>", otherwise the lines are read like a deal file. When
+/// the deal is complete the board is sent, an invalid deal closes the
+/// connection.
+///
+/// @param connection the player
+/// @param line the line
+//
+void serveDealLine(Connection* connection, char* line)
+{
+  static const char invalid[] = "[ERR] Invalid file!\n";
+  Game *game = connection->game_;
+  Card *card = &game->card_instance_[connection->cards_];
+  unsigned long long deal_number;
+  char *tok;
+  int number;
+  if (checkForEmptyLine(line, strlen(line)) == 0)
+  {
+    return;
+  }
+  line[strcspn(line, "\r\n")] = '\0';
+  if ((connection->cards_ == 0) && (strncmp(line, "deal ", 5) == 0))
+  {
+    tok = &line[5 + strspn(&line[5], " ")];
+    if (readDealNumber(tok, &deal_number) != 0)
+    {
+      addReply(connection, invalid, sizeof(invalid) - 1);
+      connection->closing_ = 1;
+      return;
+    }
+    generateDeal(deal_number, game->card_instance_);
+    connection->cards_ = 26;
+  }
+  else
+  {
+    if (readDealLine(line, strlen(line), card) != 0)
+    {
+      addReply(connection, invalid, sizeof(invalid) - 1);
+      connection->closing_ = 1;
+      return;
+    }
+    number = getCardNumber(card);
+    if ((connection->mask_ & (1UL << number)) != 0)
+    {
+      addReply(connection, invalid, sizeof(invalid) - 1);
+      connection->closing_ = 1;
+      return;
+    }
+    connection->mask_ |= 1UL << number;
+    connection->cards_++;
+  }
+  if (connection->cards_ == 26)
+  {
+    startGame(game);
+    connection->reply_length_ = renderGame(game, connection->reply_);
+    addReply(connection, "esp> ", 5);
+  }
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Runs one command of a player and puts what the game would print into the
+/// reply, see mainGameFunction.
+///
+/// @param connection the player
+/// @param line the command, it is changed
+//
+void serveCommand(Connection* connection, char* line)
+{
+  static const char help[] = HELP_TEXT;
+  static const char invalid_command[] = "[INFO] Invalid command!\n";
+  static const char invalid_move[] = "[INFO] Invalid move command!\n";
+  static const char no_solve[] = "[INFO] Solve is not available!\n";
+  static const char no_hint[] = "[INFO] Hint is not available!\n";
+  static const char no_rank[] = "[INFO] Rank is not available!\n";
+  static const char no_undo[] = "[INFO] Nothing to undo!\n";
+  static const char no_redo[] = "[INFO] Nothing to redo!\n";
+  static const char no_memory[] = "[ERR] Out of memory\n";
+  Game *game = connection->game_;
+  int move_var = parseUserInput(line);
+  int err_var;
+  if (move_var == -2)
+  {
+    game->invalid_++;
+    addReply(connection, invalid_command, sizeof(invalid_command) - 1);
+  }
+  else if (move_var == -1)
+  {
+    addReply(connection, help, sizeof(help) - 1);
+  }
+  else if (move_var == -3)
+  {
+    addReply(connection, no_solve, sizeof(no_solve) - 1);
+  }
+  else if (move_var == -7)
+  {
+    addReply(connection, no_hint, sizeof(no_hint) - 1);
+  }
+  else if (move_var == -8)
+  {
+    addReply(connection, no_rank, sizeof(no_rank) - 1);
+  }
+  else if ((move_var == -5) || (move_var == -6))
+  {
+    err_var = (move_var == -5) ? undoGame(game) : redoGame(game);
+    if (err_var == -2)
+    {
+      game->invalid_++;
+      if (move_var == -5)
+      {
+        addReply(connection, no_undo, sizeof(no_undo) - 1);
+      }
+      else
+      {
+        addReply(connection, no_redo, sizeof(no_redo) - 1);
+      }
+    }
+    else
+    {
+      connection->reply_length_ += renderGame(game, &connection->reply_[
+                                              connection->reply_length_]);
+    }
+  }
+  else if (move_var == 0)
+  {
+    connection->closing_ = 1;
+    return;
+  }
+  else
+  {
+    err_var = applyMove(game, move_var);
+    if (err_var == 2)
+    {
+      addReply(connection, no_memory, sizeof(no_memory) - 1);
+      connection->closing_ = 1;
+      return;
+    }
+    else if ((err_var == 0) || (err_var == 1))
+    {
+      connection->reply_length_ += renderGame(game, &connection->reply_[
+                                              connection->reply_length_]);
+      if (err_var == 1)
+      {
+        connection->closing_ = 1;
+        return;
+      }
+    }
+    else if (err_var != MOVE_SAME_DECK)
+    {
+      addReply(connection, invalid_move, sizeof(invalid_move) - 1);
+    }
+  }
+  addReply(connection, "esp> ", 5);
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Adds text to the reply of a connection. A reply is at most a board and
+/// a message, which always fits.
+///
+/// @param connection the player
+/// @param text the text
+/// @param length number of characters in text
+//
+void addReply(Connection* connection, const char* text, int length)
+{
+  memcpy(&connection->reply_[connection->reply_length_], text, length);
+  connection->reply_length_ += length;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Sends as much of the reply as the socket takes.
+///
+/// @param connection the player
+///
+/// @return 0 if the reply was sent or the rest has to wait
+/// @return -1 if the player is gone
+//
+int sendReply(Connection* connection)
+{
+  ssize_t sent;
+  while (connection->reply_sent_ < connection->reply_length_)
+  {
+    sent = send(connection->socket_,
+                &connection->reply_[connection->reply_sent_],
+                connection->reply_length_ - connection->reply_sent_,
+                MSG_NOSIGNAL);
+    if (sent < 0)
+    {
+      return ((errno == EAGAIN) || (errno == EINTR)) ? 0 : -1;
+    }
+    connection->reply_sent_ += sent;
+  }
+  connection->reply_length_ = 0;
+  connection->reply_sent_ = 0;
+  return 0;
+}
+
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Solves every deal of the files as a pipeline of three stages, so reading,
+/// solving and printing overlap. A reader thread parses the files into
+/// jobs, the solver threads take them from a queue and solve each deal on
+/// its own, and this thread takes the results from a second queue and
+/// prints them in the order of the files. The lines are those of
+/// solveDealFile, "<file-name> won moves=<n>" for a deal file. Both queues
+/// are bounded and lock free, a stage that finds its queue full or empty
+/// yields. At most SWEEP_WINDOW deals are on the way at any time.
+///
+/// @param count number of files
+/// @param paths the deal files and binary deal files
+/// @param threads number of solver threads
+///
+/// @return 0 if all deals were solved
+/// @return 2 if out of memory
+//
+int mainSweepFunction(int count, char** paths, int threads)
+{
+  int i;
+  int started = 0;
+  int err_var = 0;
+  long written = 0;
+  pthread_t reader;
+  pthread_t *solvers = (pthread_t*)malloc(threads * sizeof(pthread_t));
+  SweepJob *window = (SweepJob*)malloc(SWEEP_WINDOW * sizeof(SweepJob));
+  char *ready = (char*)calloc(SWEEP_WINDOW, 1);
+  SweepJob job;
+  Sweep sweep;
+  sweep.paths_ = paths;
+  sweep.count_ = count;
+  atomic_init(&sweep.read_, 0);
+  atomic_init(&sweep.reading_, 1);
+  atomic_init(&sweep.written_, 0);
+  atomic_init(&sweep.stop_, 0);
+  sweep.deals_.cells_ = NULL;
+  sweep.results_.cells_ = NULL;
+  if ((solvers == NULL) || (window == NULL) || (ready == NULL) ||
+      (initSweepQueue(&sweep.deals_, SWEEP_QUEUE_SIZE) == 2) ||
+      (initSweepQueue(&sweep.results_, SWEEP_QUEUE_SIZE) == 2) ||
+      (pthread_create(&reader, NULL, sweepReaderFunction, &sweep) != 0))
+  {
+    free(solvers);
+    free(window);
+    free(ready);
+    free(sweep.deals_.cells_);
+    free(sweep.results_.cells_);
+    printf("[ERR] Out of memory\n");
+    return 2;
+  }
+  for (started = 0; started < threads; started++)
+  {
+    if (pthread_create(&solvers[started], NULL, sweepSolverFunction,
+                       &sweep) != 0)
+    {
+      break;
+    }
+  }
+  if (started == 0)
+  {
+    atomic_store(&sweep.stop_, 1);
+    err_var = 2;
+  }
+  while ((atomic_load(&sweep.stop_) == 0) &&
+         ((atomic_load(&sweep.reading_) == 1) ||
+          (written < atomic_load(&sweep.read_))))
+  {
+    if (popSweepJob(&sweep.results_, &job) == 0)
+    {
+      sched_yield();
+      continue;
+    }
+    window[job.sequence_ % SWEEP_WINDOW] = job;
+    ready[job.sequence_ % SWEEP_WINDOW] = 1;
+    while (ready[written % SWEEP_WINDOW] == 1)
+    {
+      ready[written % SWEEP_WINDOW] = 0;
+      if (window[written % SWEEP_WINDOW].result_ == 2)
+      {
+        atomic_store(&sweep.stop_, 1);
+        err_var = 2;
+        break;
+      }
+      printSweepJob(&sweep, &window[written % SWEEP_WINDOW]);
+      written++;
+    }
+    atomic_store(&sweep.written_, written);
+  }
+  pthread_join(reader, NULL);
+  for (i = 0; i < started; i++)
+  {
+    pthread_join(solvers[i], NULL);
+  }
+  if (err_var == 2)
+  {
+    printf("[ERR] Out of memory\n");
+  }
+  free(solvers);
+  free(window);
+  free(ready);
+  free(sweep.deals_.cells_);
+  free(sweep.results_.cells_);
+  return err_var;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// The reader stage of a sweep. A binary deal file gives one job per deal,
+/// any other file is read as a DealStream, with the deals numbered if there
+/// is more than one. An invalid deal gives a job that is already done, the
+/// solvers pass it on.
+///
+/// @param argument the Sweep
+///
+/// @return NULL
+//
+void* sweepReaderFunction(void* argument)
+{
+  Sweep *sweep = (Sweep*)argument;
+  SweepJob job;
+  DealFile deals;
+  DealStream stream;
+  Card card_instance[26];
+  size_t i;
+  int file;
+  int numbered;
+  long sequence = 0;
+  for (file = 0; (file < sweep->count_) &&
+       (atomic_load(&sweep->stop_) == 0); file++)
+  {
+    job.file_ = file;
+    job.result_ = 0;
+    if (openDealFile(sweep->paths_[file], &deals) == 0)
+    {
+      for (i = 0; i < deals.count_; i++)
+      {
+        job.sequence_ = sequence++;
+        job.deal_ = (long)i;
+        memcpy(job.cards_, deals.data_ + DEAL_MAGIC_SIZE + i * DEAL_SIZE,
+               DEAL_SIZE);
+        if (queueSweepJob(sweep, &sweep->deals_, &job) == 0)
+        {
+          break;
+        }
+        atomic_store(&sweep->read_, sequence);
+      }
+      closeDealFile(&deals);
+      continue;
+    }
+    job.deal_ = -1;
+    if (openDealStream(&stream, sweep->paths_[file]) == 3)
+    {
+      job.sequence_ = sequence++;
+      job.result_ = 3;
+      if (queueSweepJob(sweep, &sweep->deals_, &job) == 0)
+      {
+        break;
+      }
+      atomic_store(&sweep->read_, sequence);
+      continue;
+    }
+    job.result_ = readStreamDeal(&stream, card_instance);
+    numbered = (stream.next_result_ != 1);
+    if ((job.result_ == 1) && (numbered == 0))
+    {
+      job.result_ = 3;
+    }
+    while (job.result_ != 1)
+    {
+      job.sequence_ = sequence++;
+      if (numbered == 1)
+      {
+        job.deal_ = stream.deals_ - 1;
+      }
+      if (job.result_ == 0)
+      {
+        encodeDeal(card_instance, job.cards_);
+      }
+      if (queueSweepJob(sweep, &sweep->deals_, &job) == 0)
+      {
+        break;
+      }
+      atomic_store(&sweep->read_, sequence);
+      job.result_ = (stream.next_result_ == 1) ? 1 :
+                    readStreamDeal(&stream, card_instance);
+    }
+    closeDealStream(&stream);
+  }
+  atomic_store(&sweep->reading_, 0);
+  return NULL;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// A solver of a sweep. Takes deals until the reader is done and the queue
+/// is empty, solves each with solveGame and queues the result.
+///
+/// @param argument the Sweep
+///
+/// @return NULL
+//
+void* sweepSolverFunction(void* argument)
+{
+  Sweep *sweep = (Sweep*)argument;
+  SweepJob job;
+  Solution solution;
+  Arena arena = {NULL, NULL};
+  Card card_instance[26];
+  Board board;
+  while (atomic_load(&sweep->stop_) == 0)
+  {
+    if (popSweepJob(&sweep->deals_, &job) == 0)
+    {
+      // the reader may have queued its last deal after the failed pop
+      if ((atomic_load(&sweep->reading_) == 0) &&
+          (popSweepJob(&sweep->deals_, &job) == 0))
+      {
+        break;
+      }
+      sched_yield();
+      continue;
+    }
+    if (job.result_ == 0)
+    {
+      job.moves_ = 0;
+      if (decodeDeal(job.cards_, card_instance) == 3)
+      {
+        job.result_ = 3;
+      }
+      else
+      {
+        setFirstPointers(&board, card_instance);
+        job.result_ = solveDeal(&board, card_instance, &solution, 1, &arena);
+        job.moves_ = solution.length_;
+        resetArena(&arena);
+      }
+    }
+    if (queueSweepJob(sweep, &sweep->results_, &job) == 0)
+    {
+      break;
+    }
+  }
+  freeArena(&arena);
+  return NULL;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Allocates the cells of a sweep queue.
+///
+/// @param queue the queue
+/// @param size number of cells, a power of 2
+///
+/// @return 0 if the queue is ready
+/// @return 2 if out of memory
+//
+int initSweepQueue(SweepQueue* queue, size_t size)
+{
+  size_t i;
+  queue->cells_ = (SweepCell*)malloc(size * sizeof(SweepCell));
+  if (queue->cells_ == NULL)
+  {
+    return 2;
+  }
+  for (i = 0; i < size; i++)
+  {
+    atomic_init(&queue->cells_[i].sequence_, i);
+  }
+  queue->mask_ = size - 1;
+  atomic_init(&queue->head_, 0);
+  atomic_init(&queue->tail_, 0);
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Adds a job at the tail of a sweep queue if there is room.
+///
+/// @param queue the queue
+/// @param job the job, it is copied
+///
+/// @return 1 if the job was added
+/// @return 0 if the queue is full
+//
+int pushSweepJob(SweepQueue* queue, SweepJob* job)
+{
+  SweepCell *cell;
+  size_t sequence;
+  size_t position = atomic_load_explicit(&queue->tail_, memory_order_relaxed);
+  while (1)
+  {
+    cell = &queue->cells_[position & queue->mask_];
+    sequence = atomic_load_explicit(&cell->sequence_, memory_order_acquire);
+    if (sequence == position)
+    {
+      if (atomic_compare_exchange_weak_explicit(&queue->tail_, &position,
+                                                position + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    else if ((long)(sequence - position) < 0)
+    {
+      return 0;
+    }
+    else
+    {
+      position = atomic_load_explicit(&queue->tail_, memory_order_relaxed);
+    }
+  }
+  cell->job_ = *job;
+  atomic_store_explicit(&cell->sequence_, position + 1, memory_order_release);
+  return 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Takes the job at the head of a sweep queue if there is one.
+///
+/// @param queue the queue
+/// @param job where the job is stored
+///
+/// @return 1 if a job was taken
+/// @return 0 if the queue is empty
+//
+int popSweepJob(SweepQueue* queue, SweepJob* job)
+{
+  SweepCell *cell;
+  size_t sequence;
+  size_t position = atomic_load_explicit(&queue->head_, memory_order_relaxed);
+  while (1)
+  {
+    cell = &queue->cells_[position & queue->mask_];
+    sequence = atomic_load_explicit(&cell->sequence_, memory_order_acquire);
+    if (sequence == position + 1)
+    {
+      if (atomic_compare_exchange_weak_explicit(&queue->head_, &position,
+                                                position + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    else if ((long)(sequence - (position + 1)) < 0)
+    {
+      return 0;
+    }
+    else
+    {
+      position = atomic_load_explicit(&queue->head_, memory_order_relaxed);
+    }
+  }
+  *job = cell->job_;
+  atomic_store_explicit(&cell->sequence_, position + queue->mask_ + 1,
+                        memory_order_release);
+  return 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Queues a job of a sweep, yielding while the queue is full. New deals
+/// also wait until the writer is less than SWEEP_WINDOW deals behind, so
+/// every result has its place in the window of the writer.
+///
+/// @param sweep the sweep
+/// @param queue the queue
+/// @param job the job
+///
+/// @return 1 if the job was queued
+/// @return 0 if the sweep was stopped
+//
+int queueSweepJob(Sweep* sweep, SweepQueue* queue, SweepJob* job)
+{
+  while ((queue == &sweep->deals_) &&
+         (job->sequence_ - atomic_load(&sweep->written_) >= SWEEP_WINDOW))
+  {
+    if (atomic_load(&sweep->stop_) == 1)
+    {
+      return 0;
+    }
+    sched_yield();
+  }
+  while (pushSweepJob(queue, job) == 0)
+  {
+    if (atomic_load(&sweep->stop_) == 1)
+    {
+      return 0;
+    }
+    sched_yield();
+  }
+  return 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+///
+/// Prints the line of a solved job.
+///
+/// @param sweep the sweep
+/// @param job the job
+//
+void printSweepJob(Sweep* sweep, SweepJob* job)
+{
+  static const char *results[] = {"lost", "won", "", "invalid-deal"};
+  printf("%s", sweep->paths_[job->file_]);
+  if (job->deal_ >= 0)
+  {
+    printf(":%ld", job->deal_);
+  }
+  if (job->result_ == 1)
+  {
+    printf(" won moves=%d\n", job->moves_);
+  }
+  else
+  {
+    printf(" %s\n", results[job->result_]);
+  }
+}
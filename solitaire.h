@@ -0,0 +1,57 @@
+//-----------------------------------------------------------------------------
+//
+// The game engine of solitaire.c as a library. A game holds all of its
+// state, nothing is read from stdin or printed, so any number of games can
+// be played in one process, also from several threads as long as every game
+// is used by one thread at a time.
+//
+// Build the engine without main with:
+// gcc -O2 -pthread -DSOLITAIRE_LIBRARY -c solitaire.c
+//
+//-----------------------------------------------------------------------------
+//
+
+#ifndef SOLITAIRE_H
+#define SOLITAIRE_H
+
+#include <stddef.h>
+
+// Why a move is invalid, returned by applyMove.
+#define MOVE_STOCK_COVERED -10
+#define MOVE_FROM_DEPOSIT -11
+#define MOVE_TO_STOCK -12
+#define MOVE_SAME_DECK -13
+#define MOVE_DEPOSIT_COVERED -14
+#define MOVE_DEPOSIT_ACE -15
+#define MOVE_DEPOSIT_SEQUENCE -16
+#define MOVE_INVALID_RUN -17
+#define MOVE_TABLEAU_KING -18
+#define MOVE_TABLEAU_SEQUENCE -19
+// The move_var names no card (1 to 26) or no deck (0 to 6).
+#define MOVE_OUT_OF_RANGE -20
+#define MOVE_RULES 11
+
+// Most moves there can be in one position, the size listMoves needs.
+#define MAX_MOVES 156
+
+// Size of the buffer renderGame needs.
+#define FRAME_SIZE 720
+
+// A move is a move_var: deck * 100 + card number + 1, the card number is
+// value - 1 for red and value + 12 for black cards.
+typedef struct _Game_ Game;
+
+Game* newGame(void);
+void freeGame(Game* game);
+int initGame(Game* game, const char* text, size_t length);
+int initGameFromDeal(Game* game, const unsigned char* deal);
+int applyMove(Game* game, int move_var);
+int undoGame(Game* game);
+int redoGame(Game* game);
+int listMoves(Game* game, int* moves);
+int isGameWon(Game* game);
+unsigned long long hashGame(Game* game);
+int renderGame(Game* game, char* frame);
+int parseUserInput(char* read_line);
+
+#endif